@@ -0,0 +1,66 @@
+#pragma once
+// Shape and colors of the airplane, shared by every render path.
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+
+#include "mesh_cache.h"
+
+#define CIRCLE_SEGMENT 64
+// Radius of the fuselage cylinder, the part whose segments change with the level of detail
+#define BODY_RADIUS 0.5f
+
+#define RED 0.905f, 0.298f, 0.235f
+#define BLUE 0.203f, 0.596f, 0.858f
+#define GREEN 0.18f, 0.8f, 0.443f
+
+// Largest fleet accepted by --instances
+#define MAX_AIRPLANE_COUNT 1000000
+
+/// @brief A piece of the airplane, placed relative to the airplane origin.
+struct AirplanePart {
+  MeshCache::Handle mesh;
+  glm::mat4 transform;
+  glm::vec3 color;
+  // 1 for the right wing, -1 for the left wing, 0 for parts that do not flap
+  float wingSide;
+};
+
+/// @brief Flight of the airplanes, the same for every airplane of the fleet.
+struct FlightState {
+  // World position
+  glm::dvec3 position = glm::dvec3(0.0);
+  // Degrees around +y, 0 faces -z
+  float heading = 0.0f;
+  // Degrees the wings are raised around the body axis
+  float wingAngle = 0.0f;
+  // 1 while the wings go up, -1 while they go down
+  float flapDirection = 1.0f;
+
+  /// @return Heading of every airplane, turns airplane space around the airplane origin
+  glm::mat4 getRotation() const;
+  bool operator==(const FlightState& other) const;
+  bool operator!=(const FlightState& other) const { return !(*this == other); }
+};
+
+/// @return State between a (alpha 0) and b (alpha 1)
+FlightState interpolate(const FlightState& a, const FlightState& b, float alpha);
+/// @return part.transform with the wing raised by wingAngle degrees around the body axis
+glm::mat4 partTransform(const AirplanePart& part, float wingAngle);
+
+/// @brief Per-airplane data of the fleet.
+struct AirplaneInstance {
+  // World position of the airplane origin at flight position 0, the flight moves every airplane by its position
+  glm::dvec3 position;
+  // Tint multiplied with the part colors, normalized unsigned bytes
+  glm::u8vec4 color;
+};
+
+/// @return Body, wings and tail, same layout as render_body, render_wings and render_tail in main.cpp
+/// @param bodySegments Segments of the fuselage, the other parts are the same at every level of detail
+std::vector<AirplanePart> makeAirplaneParts(MeshCache& cache, int bodySegments = CIRCLE_SEGMENT);
+/// @return Sphere enclosing every part in airplane space at any wing angle, CPU only, valid for the immediate path too
+BoundingSphere airplaneBoundingSphere();
+/// @return count airplanes on a grid centered on the origin, a single airplane stays at the origin untinted
+std::vector<AirplaneInstance> makeFleet(int count);
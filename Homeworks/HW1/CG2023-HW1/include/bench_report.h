@@ -0,0 +1,51 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "gpu_timer.h"
+#include "lod_selector.h"
+
+/**
+ * @brief Per frame measurements of one benchmark run, written as JSON.
+ *
+ * Times are in milliseconds. The report has mean, p50, p95, p99 and max of the CPU and GPU frame times and of the GPU
+ * time of each pass, GPU times are null if timer queries are not supported. Presentation jitter is the standard
+ * deviation of the time between swaps. Draw calls and vertices have mean, min and max per frame.
+ */
+struct BenchReport {
+  /// @brief CPU time of one viewport of --views, culling and draw submission
+  struct View {
+    std::string name;
+    std::vector<double> cpuTimes;
+    // Frustum culling of the last frame
+    uint64_t airplanesDrawn = 0;
+  };
+
+  std::string renderer;
+  int instanceCount = 0;
+  bool headless = false;
+  // Pacing mode in effect, see FramePacer
+  std::string pacing;
+  std::vector<double> cpuFrameTimes;
+  std::vector<double> gpuFrameTimes;
+  std::array<std::vector<double>, GPU_PASS_COUNT> gpuPassTimes;
+  // Time between consecutive swaps
+  std::vector<double> presentIntervals;
+  // Per frame, culling and levels of detail change the work from frame to frame
+  std::vector<uint64_t> drawCalls;
+  std::vector<uint64_t> vertices;
+  // Frustum culling of the last frame, summed over the views
+  uint64_t airplanesDrawn = 0;
+  uint64_t airplanesCulled = 0;
+  std::vector<View> views;
+  // Airplanes drawn at each level of detail in the last frame, summed over the views
+  std::array<uint64_t, LOD_LEVEL_COUNT> lodLevelCounts = {};
+
+  /// @brief Append the GPU times of one frame
+  void addGpuFrame(const GpuTimer::FrameTimes& frame);
+  /// @brief Write the report as a single JSON object
+  void write(std::ostream& out) const;
+};
@@ -1,31 +1,106 @@
 #pragma once
+#include <array>
+#include <cstdint>
+
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "input_queue.h"
+
+/**
+ * @brief Camera with a double precision world position, everything it hands out is relative to that position.
+ *
+ * The view matrix only rotates, objects are translated by toCameraRelative() of their world position, so float
+ * precision is best next to the camera however far it is from the world origin.
+ */
 class Camera {
  public:
-  Camera(glm::vec3 _position);
-  void initialize(float aspectRatio);
-  void move(GLFWwindow* window);
+  Camera(glm::dvec3 _position);
+  /// @param reverseZ Use an infinite reverse-Z projection, see updateProjectionMatrix()
+  void initialize(float aspectRatio, bool reverseZ = false);
+  /**
+   * @brief Apply the mouse motion that arrived up to sampleTime.
+   *
+   * Call as late as possible before the matrices are used, events after sampleTime stay queued for the next frame.
+   */
+  void move(double sampleTime);
+  /// @brief Place the camera, WASD motion is integrated by Simulation
+  void setPosition(const glm::dvec3& _position);
+  /// @brief Turn the camera to face target with up as close to worldUp as possible, for cameras without a mouse
+  void lookAt(const glm::dvec3& target, const glm::vec3& worldUp = glm::vec3(0.0f, 1.0f, 0.0f));
+  /// @brief Queue a cursor position with the glfwGetTime() it arrived at, call from the cursor position callback
+  void onCursorPos(double x, double y, double time);
   void updateViewMatrix();
+  /**
+   * @brief Perspective projection for aspectRatio.
+   *
+   * Standard maps zNear..zFar to depth -1..1, zFar stays at the 100 of the assignment, so anything further than 100
+   * units from the camera is clipped and culled. Reverse-Z has no far plane and maps zNear..infinity to depth 1..0, it
+   * needs glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE), a depth clear of 0 and GL_GEQUAL.
+   */
   void updateProjectionMatrix(float aspectRatio);
 
+  const glm::dvec3& getPosition() const { return position; }
+  /// @return world - position, where world appears in the space of the view matrix
+  glm::vec3 toCameraRelative(const glm::dvec3& world) const { return glm::vec3(world - position); }
+  bool isReverseZ() const { return reverseZ; }
+  /// @return Directions W and D move along
+  const glm::vec3& getFront() const { return front; }
+  const glm::vec3& getRight() const { return right; }
+
   const float* getProjectionMatrix() const { return glm::value_ptr(projectionMatrix); }
   const float* getViewMatrix() const { return glm::value_ptr(viewMatrix); }
+  /// @return projection * view, cached
+  const float* getViewProjectionMatrix() const { return glm::value_ptr(viewProjectionMatrix); }
+  /// @return Inverse of projection * view, maps NDC back to world space
+  const float* getInverseViewProjectionMatrix() const { return glm::value_ptr(inverseViewProjectionMatrix); }
+  /**
+   * @brief Camera relative frustum planes in the order left, right, bottom, top, near, far.
+   *
+   * A plane is (normal, d) with unit normal pointing inside, a point p is inside if dot(normal, p) + d >= 0. The far
+   * plane of reverse-Z is (0, 0, 0, 1), every point is inside.
+   */
+  const std::array<glm::vec4, 6>& getFrustumPlanes() const { return frustumPlanes; }
+  /**
+   * @return Changes whenever the view or projection matrix changes.
+   *
+   * Versions increase monotonically and are never shared between cameras, so an equal version means the same
+   * matrices and caches built from them can be reused.
+   */
+  uint64_t getVersion() const { return version; }
+  /// @return Seconds from the oldest mouse event applied by the last move() to its sample time, 0 if there was none
+  double getInputLatency() const { return inputLatency; }
+  uint64_t getDroppedInputCount() const { return inputQueue.getDroppedCount(); }
 
 private:
-  glm::vec3 position;
+  glm::dvec3 position;
   glm::vec3 up;
   glm::vec3 front;
   glm::vec3 right;
 
   glm::quat rotation;
-  // TODO (optional): Change these values if your WASD or mouse move too slow or too fast.
-  constexpr static float keyboardMoveSpeed = 0.1f;
+  // TODO (optional): Change this value if your mouse move too slow or too fast, WASD is in simulation.h.
   constexpr static float mouseMoveSpeed = 0.001f;
 
+  // Cursor positions waiting for move(), the last one it applied and how long the oldest one waited
+  InputQueue inputQueue;
+  glm::dvec2 lastCursor = glm::dvec2(0.0);
+  bool hasCursor = false;
+  double inputLatency = 0.0;
+
+  /// @brief Recompute everything derived from view and projection and take a new version
+  void updateDerivedMatrices();
+
+  bool reverseZ = false;
   // matrix
   glm::mat4 projectionMatrix;
   glm::mat4 viewMatrix;
+  // Derived from the two above
+  glm::mat4 viewProjectionMatrix;
+  glm::mat4 inverseViewProjectionMatrix;
+  std::array<glm::vec4, 6> frustumPlanes;
+  uint64_t version = 0;
+  // Last version handed out by any camera
+  static uint64_t lastVersion;
 };
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+#include <array>
+#include <vector>
+
+#include "mesh.h"
+#include "utils.h"
+
+/// @brief Point on the unit circle in the XZ plane, also the outward normal of the cylinder side there.
+struct CirclePoint {
+  float x;
+  float z;
+};
+
+/// @brief Sample the unit circle at i * 2pi / Segments, the first point is repeated at the end to close the seam.
+template <int Segments>
+constexpr std::array<CirclePoint, Segments + 1> makeUnitCircle() {
+  std::array<CirclePoint, Segments + 1> circle{};
+  for (int i = 0; i < Segments; ++i) {
+    double angle = 2 * utils::PI<double>() * i / Segments;
+    circle[i] = {static_cast<float>(utils::cos(angle)), static_cast<float>(utils::sin(angle))};
+  }
+  circle[Segments] = circle[0];
+  return circle;
+}
+
+/// @brief Cylinder generator with its unit circle baked into a read-only table at compile time.
+template <int Segments>
+struct CylinderMesh {
+  static_assert(Segments >= 3, "A cylinder needs at least 3 segments");
+  static constexpr std::array<CirclePoint, Segments + 1> circle = makeUnitCircle<Segments>();
+
+  static MeshData build(float radius, float height) { return mesh::cylinder(radius, height, circle.data(), Segments); }
+};
+
+/**
+ * @brief Unit circle for an arbitrary segment count.
+ *
+ * Common segment counts (8, 16, 32, 64, 128) use the tables of CylinderMesh and cost no trigonometry, other counts are
+ * computed once at construction.
+ */
+class UnitCircle final {
+ public:
+  // Not copyable
+  DELETE_COPY(UnitCircle)
+  // Not movable, points may refer to storage
+  DELETE_MOVE(UnitCircle)
+  explicit UnitCircle(int segments);
+
+  /// @return Point i, valid for i in [0, segments], point segments equals point 0
+  const CirclePoint& operator[](int i) const { return points[i]; }
+  const CirclePoint* data() const { return points; }
+  /// @return true if the points come from a compile-time table
+  bool isBaked() const { return storage.empty(); }
+
+ private:
+  std::vector<CirclePoint> storage;
+  const CirclePoint* points;
+};
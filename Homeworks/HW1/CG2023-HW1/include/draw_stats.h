@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * @brief Counts draw calls and submitted vertices per frame.
+ *
+ * Every draw of the application reports itself here. An immediate mode glBegin/glEnd pair counts as one draw call.
+ */
+class DrawStats final {
+ public:
+  // Only static members
+  DrawStats() = delete;
+
+  /// @brief Record one draw call that submits vertices for each of instances
+  static void record(uint64_t vertices, uint64_t instances = 1) {
+    ++drawCallCount;
+    vertexCount += vertices * instances;
+  }
+  /// @brief Start counting a new frame
+  static void beginFrame();
+  /// @brief Finish counting the frame, its counts become available
+  static void endFrame();
+  /// @return Draw calls issued during the last finished frame
+  static uint64_t getDrawCallCount() { return lastDrawCallCount; }
+  /// @return Vertices submitted during the last finished frame, instanced draws count every instance
+  static uint64_t getVertexCount() { return lastVertexCount; }
+
+ private:
+  static uint64_t drawCallCount, vertexCount;
+  static uint64_t lastDrawCallCount, lastVertexCount;
+};
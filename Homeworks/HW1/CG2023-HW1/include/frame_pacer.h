@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+
+#include "options.h"
+#include "utils.h"
+
+/**
+ * @brief Sets the swap interval of a pacing mode and holds the frame rate of PacingMode::Limit.
+ *
+ * The limiter sleeps until SPIN_TIME before the deadline of the frame, then spins on glfwGetTimerValue, since sleeps
+ * may overshoot by a scheduler tick. Deadlines advance by a fixed period so errors do not add up. The time between
+ * consecutive swaps is measured in every mode, the spread of these intervals is the presentation jitter.
+ */
+class FramePacer final {
+ public:
+  DELETE_COPY(FramePacer)
+  DELETE_MOVE(FramePacer)
+  /// @brief Apply the swap interval of mode, needs a current OpenGL context
+  /// @param targetFps Frame rate of PacingMode::Limit, ignored by the other modes
+  FramePacer(PacingMode mode, int targetFps);
+
+  /// @brief Call right before glfwSwapBuffers, waits for the deadline of the frame in PacingMode::Limit
+  void waitForDeadline();
+  /// @brief Call right after glfwSwapBuffers, @return Milliseconds since the previous swap, 0 for the first one
+  double framePresented();
+  /// @brief Nothing was presented this time, the next interval and deadline start from the next frame
+  void skipFrame();
+  /// @return Mode in effect, Adaptive falls back to VSync without a swap control tear extension
+  PacingMode getMode() const { return mode; }
+
+ private:
+  // Below this the limiter spins instead of sleeping, in seconds
+  static constexpr double SPIN_TIME = 0.002;
+  PacingMode mode;
+  uint64_t timerFrequency;
+  // Timer ticks per frame and deadline of the next frame in PacingMode::Limit
+  uint64_t period = 0;
+  uint64_t deadline = 0;
+  // Timer value of the previous swap, 0 before the first one
+  uint64_t lastPresentTime = 0;
+};
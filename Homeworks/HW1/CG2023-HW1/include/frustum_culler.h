@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "airplane.h"
+#include "camera.h"
+#include "mesh.h"
+
+/**
+ * @brief Tests the bounding sphere of every airplane against the camera frustum.
+ *
+ * Spheres are stored as structure of arrays and tested 8 at a time with AVX, 4 at a time with SSE, or one at a time
+ * elsewhere. Culling only runs again when the camera version or the flight of the fleet changes.
+ */
+class FrustumCuller final {
+ public:
+  // Plain data, copying is fine
+  DEFAULT_COPY(FrustumCuller)
+  DEFAULT_MOVE(FrustumCuller)
+  /// @param fleet Airplanes to cull, a flight moves every sphere by the same offset
+  /// @param bounds Sphere enclosing one airplane in airplane space, see airplaneBoundingSphere()
+  FrustumCuller(const std::vector<AirplaneInstance>& fleet, const BoundingSphere& bounds);
+
+  /**
+   * @brief Update the visible list for camera, does nothing if neither the camera nor the flight changed.
+   *
+   * @param flight Moves and turns every airplane of the fleet, see FlightState
+   */
+  void cull(const Camera& camera, const FlightState& flight = FlightState());
+  /// @return Indices into the fleet of the airplanes inside the frustum, in fleet order
+  const std::vector<uint32_t>& getVisible() const { return visible; }
+  std::size_t getVisibleCount() const { return visible.size(); }
+  std::size_t getCulledCount() const { return count - visible.size(); }
+  /// @return Changes whenever the visible list is rebuilt, never 0
+  uint64_t getVersion() const { return version; }
+
+ private:
+  std::size_t count;
+  // Sphere centers relative to origin, padded to a multiple of 8. Offsets within the fleet stay small, only origin is
+  // moved next to the camera in double precision
+  std::vector<float> centerX, centerY, centerZ;
+  glm::dvec3 origin;
+  float radius;
+  std::vector<uint32_t> visible;
+  // Sphere center in airplane space and the flight of the last cull
+  glm::vec3 localCenter;
+  glm::dvec3 flightPosition = glm::dvec3(0.0);
+  float flightHeading = 0.0f;
+  uint64_t cameraVersion = 0;
+  uint64_t version = 0;
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include <glad/gl.h>
+
+#include "utils.h"
+
+/// @brief Copy of one OpenGL debug message, long messages are truncated.
+struct GLDebugMessage {
+  static constexpr std::size_t MAX_LENGTH = 512;
+  GLenum source = 0;
+  GLenum type = 0;
+  GLenum severity = 0;
+  GLuint id = 0;
+  std::array<char, MAX_LENGTH> text = {};
+};
+
+/**
+ * @brief Writes OpenGL debug messages from a background thread.
+ *
+ * The debug callback only copies the message into a bounded lock-free queue, so it never waits on I/O and may be
+ * called from any driver thread. The writer thread drains the queue and shows at most REPEAT_LIMIT messages of each id
+ * per REPEAT_WINDOW. The rest are counted, and once the window of their id ends the count is written as one line, so a
+ * message that keeps firing shows up again every window. Messages are dropped and counted when the queue is full.
+ */
+class GLDebugLog final {
+ public:
+  using Writer = void (*)(const GLDebugMessage& message);
+  // Only static members
+  GLDebugLog() = delete;
+
+  /// @brief Start the writer thread, writer formats one message
+  static void start(Writer writer);
+  /// @brief Write what is left, stop the writer thread and print the counts still suppressed and dropped
+  static void stop();
+  /// @brief Queue a message, safe to call from the debug callback of any thread
+  static void push(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message);
+
+ private:
+  static constexpr std::size_t CAPACITY = 1024;
+  static constexpr uint32_t REPEAT_LIMIT = 5;
+  static constexpr std::chrono::seconds REPEAT_WINDOW{1};
+  // Bounded queue of Dmitry Vyukov, a slot is free for position p when sequence == p, readable when sequence == p + 1
+  struct Slot {
+    std::atomic<std::size_t> sequence;
+    GLDebugMessage message;
+  };
+  /// @brief Writer thread, drains the queue until stopped
+  static void run(Writer writer);
+  /// @brief Print the counts of ids whose window ended before now, or of every id if flush, @return True if any
+  static bool reportSuppressed(std::chrono::steady_clock::time_point now, bool flush);
+  /// @return False if the queue is empty
+  static bool pop(GLDebugMessage& message);
+
+  static std::array<Slot, CAPACITY> slots;
+  static std::atomic<std::size_t> enqueuePosition;
+  static std::size_t dequeuePosition;
+  static std::atomic<uint64_t> droppedCount;
+  static std::atomic<bool> running;
+  static std::thread thread;
+};
@@ -0,0 +1,84 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+
+#include <glad/gl.h>
+
+#include "utils.h"
+
+/**
+ * @brief Shadow copy of the OpenGL state touched every frame, calls that would not change anything are dropped.
+ *
+ * Every state change of the application must go through this class, otherwise the shadow copy goes stale. Call
+ * invalidate() after changing state directly or deleting bound objects.
+ */
+class GLStateCache final {
+ public:
+  // Only static members
+  GLStateCache() = delete;
+
+  static void enable(GLenum capability) { setCapability(capability, true); }
+  static void disable(GLenum capability) { setCapability(capability, false); }
+  static void depthFunc(GLenum func);
+  static void clearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+  static void clearDepth(GLdouble depth);
+  // Fixed function lighting
+  static void shadeModel(GLenum mode);
+  static void colorMaterial(GLenum face, GLenum mode);
+  /// @brief glLightfv, GL_POSITION and GL_SPOT_DIRECTION depend on the modelview matrix and are never dropped
+  static void lightfv(GLenum light, GLenum pname, const GLfloat* params);
+  // Bindings
+  static void useProgram(GLuint program);
+  static void bindVertexArray(GLuint vertexArray);
+  static void bindBuffer(GLenum target, GLuint buffer);
+  static void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+  static void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+  /// @brief Forget everything, the next call of each kind always reaches OpenGL
+  static void invalidate();
+  /// @brief Start counting a new frame, the counts of the previous frame become available
+  static void beginFrame();
+  /// @return Calls forwarded to OpenGL during the previous frame
+  static uint32_t getIssuedCount() { return lastIssuedCount; }
+  /// @return Redundant calls dropped during the previous frame
+  static uint32_t getFilteredCount() { return lastFilteredCount; }
+
+ private:
+  static void setCapability(GLenum capability, bool enabled);
+  /// @return true if the call has to be forwarded, also updates the counters
+  static bool update(bool changed) {
+    if (changed) {
+      ++issuedCount;
+    } else {
+      ++filteredCount;
+    }
+    return changed;
+  }
+
+  // Cached values are only meaningful if the matching valid flag is set
+  static std::unordered_map<GLenum, bool> capabilities;
+  static GLenum depthFuncValue;
+  static bool depthFuncValid;
+  static std::array<GLfloat, 4> clearColorValue;
+  static bool clearColorValid;
+  static GLdouble clearDepthValue;
+  static bool clearDepthValid;
+  static GLenum shadeModelValue;
+  static bool shadeModelValid;
+  static std::array<GLenum, 2> colorMaterialValue;
+  static bool colorMaterialValid;
+  // Key is (light << 16 | pname)
+  static std::unordered_map<uint32_t, std::array<GLfloat, 4>> lightParameters;
+  static GLuint program;
+  static bool programValid;
+  static GLuint vertexArray;
+  static bool vertexArrayValid;
+  // Key is the target, or (target << 8 | index) for indexed bindings
+  static std::unordered_map<uint32_t, GLuint> buffers;
+  // Same key as buffers for indexed bindings, buffer, offset and size of glBindBufferRange
+  static std::unordered_map<uint32_t, std::array<GLintptr, 3>> bufferRanges;
+
+  static uint32_t issuedCount, filteredCount;
+  static uint32_t lastIssuedCount, lastFilteredCount;
+};
@@ -0,0 +1,74 @@
+#pragma once
+#include <array>
+#include <utility>
+#include <vector>
+
+#include <glad/gl.h>
+
+#include "utils.h"
+
+/// @brief Render passes timed on the GPU, in submission order.
+enum class GpuPass {
+  Clear,
+  Board,
+  Airplanes,
+};
+constexpr int GPU_PASS_COUNT = 3;
+/// @return Printable name of the pass
+const char* toString(GpuPass pass);
+
+/**
+ * @brief GPU time of each render pass from GL_TIMESTAMP queries.
+ *
+ * A timestamp is written when the frame starts and after each pass. Every frame in flight owns a pool of queries,
+ * pools are read back FRAME_LATENCY frames later, when the results are normally available, so the CPU does not wait.
+ * Does nothing if timer queries are not supported.
+ */
+class GpuTimer final {
+ public:
+  /// @brief Milliseconds spent by one frame, passes that were not marked stay 0
+  struct FrameTimes {
+    double total = 0.0;
+    std::array<double, GPU_PASS_COUNT> passes = {};
+  };
+
+  // Owns OpenGL queries
+  DELETE_COPY(GpuTimer)
+  DELETE_MOVE(GpuTimer)
+  /// @brief Create the query pools, needs a current OpenGL context
+  GpuTimer();
+  /// @brief Release the query pools
+  ~GpuTimer();
+
+  /// @return True if OpenGL 3.3 or GL_ARB_timer_query is available
+  static bool isSupported();
+  /// @brief Start a frame, blocks only if the pool of this frame is still in flight
+  void beginFrame();
+  /// @brief Mark the end of a pass, passes must be marked in order
+  void endPass(GpuPass pass);
+  /// @brief Finish the frame and collect the frames whose results are available
+  void endFrame();
+  /// @brief Wait for every frame in flight
+  void finish();
+  /// @return Frames collected since the last call, oldest first
+  std::vector<FrameTimes> takeResults() { return std::exchange(results, {}); }
+
+ private:
+  // Pools in flight, triple buffered
+  static constexpr int FRAME_LATENCY = 3;
+  struct Pool {
+    // Frame start, then the end of each pass
+    std::array<GLuint, GPU_PASS_COUNT + 1> queries = {};
+    std::array<bool, GPU_PASS_COUNT> marked = {};
+    // Query of the last timestamp written in this frame
+    GLuint last = 0;
+  };
+  /// @brief Read the oldest frame in flight
+  void readOldest();
+
+  bool supported;
+  std::array<Pool, FRAME_LATENCY> pools;
+  // Pool of the current frame and number of frames waiting for their results
+  int head = 0, pending = 0;
+  std::vector<FrameTimes> results;
+};
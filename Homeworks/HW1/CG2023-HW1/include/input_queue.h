@@ -0,0 +1,44 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "utils.h"
+
+/// @brief Cursor position reported by GLFW and the glfwGetTime() it arrived at.
+struct InputEvent {
+  double time = 0.0;
+  glm::dvec2 cursor = glm::dvec2(0.0);
+};
+
+/**
+ * @brief Bounded lock-free queue of timestamped input events, one producer and one consumer.
+ *
+ * The producer is the GLFW callback on the main thread, which stamps events as they arrive. The consumer is the render
+ * thread, it takes the events up to a sample time just before the frame uses them.
+ * Events are dropped and counted when the queue is full.
+ */
+class InputQueue final {
+ public:
+  InputQueue() = default;
+  DELETE_COPY(InputQueue)
+  DELETE_MOVE(InputQueue)
+
+  /// @brief Producer side, @return False if the queue was full and the event dropped
+  bool push(const InputEvent& event);
+  /// @brief Consumer side, take the oldest event if it arrived at or before time, @return False otherwise
+  bool popUntil(double time, InputEvent& event);
+
+  uint64_t getDroppedCount() const { return droppedCount.load(std::memory_order_relaxed); }
+
+ private:
+  static constexpr std::size_t CAPACITY = 1024;
+  std::array<InputEvent, CAPACITY> events;
+  // Positions only grow, each is written by one side, on separate cache lines to avoid false sharing
+  alignas(64) std::atomic<std::size_t> writePosition{0};
+  alignas(64) std::atomic<std::size_t> readPosition{0};
+  std::atomic<uint64_t> droppedCount{0};
+};
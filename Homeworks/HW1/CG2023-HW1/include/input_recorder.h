@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "utils.h"
+
+/// @brief One GLFW input callback, only the fields of its type are used.
+struct RecordedInput {
+  enum class Type : uint8_t {
+    Key,
+    CursorPos,
+    Resize,
+  };
+  Type type = Type::Key;
+  // Seconds since recording started
+  double time = 0.0;
+  // Key
+  int key = 0;
+  int action = 0;
+  // CursorPos
+  glm::dvec2 cursor = glm::dvec2(0.0);
+  // Resize, framebuffer size in pixels
+  int width = 0;
+  int height = 0;
+};
+
+/**
+ * @brief Writes input callbacks to a binary file as they happen.
+ *
+ * The file starts with the magic "HW1I" and a version byte, then each input is a type byte, the time as a double and
+ * its fields: key as int16 and action as uint8, cursor as two doubles, or width and height as int32. Values use the
+ * byte order of the machine.
+ */
+class InputRecorder final {
+ public:
+  DELETE_COPY(InputRecorder)
+  DELETE_MOVE(InputRecorder)
+  /**
+   * @param startTime glfwGetTime() that becomes time 0
+   * @throw std::runtime_error if path cannot be opened
+   */
+  InputRecorder(const std::string& path, double startTime);
+
+  void key(double time, int key, int action);
+  void cursorPos(double time, double x, double y);
+  void resize(double time, int width, int height);
+  std::size_t getCount() const { return count; }
+
+ private:
+  void write(const RecordedInput& input);
+
+  std::ofstream file;
+  double startTime;
+  std::size_t count = 0;
+};
+
+/// @brief Reads a file of InputRecorder and hands the inputs back in order.
+class InputReplayer final {
+ public:
+  /// @throw std::runtime_error if path cannot be read or is not a recording
+  explicit InputReplayer(const std::string& path);
+
+  /// @brief Take the next input if it happened at or before time, @return False otherwise
+  bool next(double time, RecordedInput& input);
+  /// @return True once every input has been taken
+  bool isFinished() const { return position == inputs.size(); }
+  std::size_t getCount() const { return inputs.size(); }
+
+ private:
+  std::vector<RecordedInput> inputs;
+  std::size_t position = 0;
+};
@@ -0,0 +1,71 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "airplane.h"
+#include "camera.h"
+#include "frustum_culler.h"
+#include "mesh.h"
+#include "utils.h"
+
+// Fuselage segment counts of the levels of detail, coarsest first, all have baked unit circles
+constexpr int LOD_LEVEL_COUNT = 5;
+constexpr std::array<int, LOD_LEVEL_COUNT> LOD_SEGMENTS = {8, 16, 32, 64, 128};
+
+/**
+ * @brief Picks the fuselage level of detail of every visible airplane from its projected bounding sphere.
+ *
+ * A level is enough while the flat sides of its fuselage stay within MAX_ERROR_PIXELS of the true circle on screen.
+ * Airplanes move to a finer level as soon as they need it, but only back to a coarser one once they are HYSTERESIS
+ * below its limit, so an airplane on the edge does not pop back and forth.
+ */
+class LodSelector final {
+ public:
+  // Plain data, copying is fine
+  DEFAULT_COPY(LodSelector)
+  DEFAULT_MOVE(LodSelector)
+  /// @param bounds Sphere enclosing one airplane in airplane space, see airplaneBoundingSphere()
+  LodSelector(std::size_t fleetSize, const BoundingSphere& bounds);
+
+  /**
+   * @brief Update the levels of the airplanes culler found visible, does nothing if culler and viewport did not change.
+   *
+   * @param viewportHeight Height in pixels of the viewport camera is drawn into
+   * @param flight Same flight as given to FrustumCuller::cull()
+   */
+  void update(const Camera& camera, int viewportHeight, const std::vector<AirplaneInstance>& fleet,
+              const FrustumCuller& culler, const FlightState& flight);
+  /// @return Level of airplane index, an index into LOD_SEGMENTS, valid for the visible airplanes of the last update()
+  int getLevel(uint32_t index) const { return levels[index]; }
+  /// @return Number of visible airplanes at each level
+  const std::array<std::size_t, LOD_LEVEL_COUNT>& getLevelCounts() const { return levelCounts; }
+  /// @return Changes whenever update() picked the levels again, never 0
+  uint64_t getVersion() const { return version; }
+
+  /// @brief Shift every level limit by a factor of 2^bias, positive values pick finer levels for all views
+  static void setBias(float _bias) { bias = _bias; }
+  static float getBias() { return bias; }
+
+ private:
+  // Largest distance in pixels between a flat side of the fuselage and the true circle
+  static constexpr float MAX_ERROR_PIXELS = 0.5f;
+  // Fraction below the limit of a coarser level before an airplane moves back to it
+  static constexpr float HYSTERESIS = 0.2f;
+  static float bias;
+
+  glm::vec3 localCenter;
+  float radius;
+  // Largest projected radius in pixels of the bounding sphere each level is good for
+  std::array<float, LOD_LEVEL_COUNT> maxPixels;
+  // Level of every airplane of the fleet, -1 before its first update
+  std::vector<int8_t> levels;
+  std::array<std::size_t, LOD_LEVEL_COUNT> levelCounts = {};
+  uint64_t cullerVersion = 0;
+  int lastViewportHeight = 0;
+  float lastBias = 0.0f;
+  uint64_t version = 0;
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "utils.h"
+
+/**
+ * @brief CPU replacement for glPushMatrix / glTranslatef / glRotatef / glPopMatrix.
+ *
+ * Products use SSE when the target has it (glm's own mat4 * mat4 is scalar). Compose the whole transform here and
+ * upload only the top once per draw.
+ */
+class MatrixStack final {
+ public:
+  // Copyable, a stack is just values
+  DEFAULT_COPY(MatrixStack)
+  DEFAULT_MOVE(MatrixStack)
+  /// @brief Stack with a single identity matrix
+  MatrixStack();
+
+  /// @brief Duplicate the top matrix, like glPushMatrix
+  void push();
+  /// @brief Drop the top matrix, like glPopMatrix
+  /// @throw std::underflow_error if only one matrix is left
+  void pop();
+  /// @brief Replace the top matrix, like glLoadMatrixf
+  void load(const glm::mat4& matrix);
+  /// @brief top = top * matrix, like glMultMatrixf
+  void multiply(const glm::mat4& matrix);
+  /// @brief Like glTranslatef
+  void translate(float x, float y, float z);
+  /// @brief Like glRotatef, angle in degrees around the axis (x, y, z)
+  void rotate(float angle, float x, float y, float z);
+  /// @brief Like glScalef
+  void scale(float x, float y, float z);
+
+  /// @return Top matrix, column major, ready for glUniformMatrix4fv or glLoadMatrixf
+  const float* data() const { return &stack.back()[0][0]; }
+  /// @return Copy of the top matrix
+  glm::mat4 top() const { return stack.back(); }
+  std::size_t depth() const { return stack.size(); }
+
+ private:
+  std::vector<glm::mat4> stack;
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "utils.h"
+
+struct CirclePoint;
+
+// Generic vertex attribute locations, shared with the scene shaders
+constexpr GLuint POSITION_ATTRIBUTE = 0;
+constexpr GLuint NORMAL_ATTRIBUTE = 1;
+
+/// @brief Interleaved vertex layout shared by every mesh.
+struct Vertex {
+  glm::vec3 position;
+  glm::vec3 normal;
+};
+
+/// @brief CPU side geometry, an indexed triangle list with counter-clockwise outward faces.
+struct MeshData {
+  std::vector<Vertex> vertices;
+  std::vector<GLuint> indices;
+};
+
+/// @brief Sphere enclosing some geometry, used for culling.
+struct BoundingSphere {
+  glm::vec3 center = glm::vec3(0.0f);
+  float radius = 0.0f;
+};
+
+// Generators for the primitives of the scene, they match draw_cylinder, draw_rectangle and draw_triangle in main.cpp
+namespace mesh {
+/// @brief Cylinder along the Y axis, centered at the origin.
+MeshData cylinder(float radius, float height, int segments);
+/// @brief Cylinder from a precomputed unit circle of segments + 1 points, see cylinder_mesh.h
+MeshData cylinder(float radius, float height, const CirclePoint* circle, int segments);
+/// @brief Cuboid centered at the origin, length along X, width along Z and height along Y.
+MeshData cuboid(float length, float width, float height);
+/// @brief Tetrahedron with apex at the origin and its base at z = height1.
+MeshData tetrahedron(float bottomEdge, float height1, float height2);
+/// @brief Square on the XZ plane facing +Y.
+MeshData board(float halfSize);
+/// @brief Sphere around the bounding box of the vertices after applying transform
+BoundingSphere boundingSphere(const MeshData& data, const glm::mat4& transform = glm::mat4(1.0f));
+}  // namespace mesh
+
+/// @brief Geometry uploaded once into a VAO + VBO + IBO, drawn with a single glDrawElements.
+class Mesh final {
+ public:
+  // Not copyable
+  DELETE_COPY(Mesh)
+  // Not movable, owns OpenGL objects
+  DELETE_MOVE(Mesh)
+  /// @brief Upload geometry, needs a current OpenGL context
+  explicit Mesh(const MeshData& data);
+  /// @brief Release OpenGL objects
+  ~Mesh();
+  /// @brief Bind the vertex array and draw all triangles, instanced if instanceCount is more than 1
+  void draw(GLsizei instanceCount = 1) const;
+  /// @brief Point the position / normal attributes and the index buffer of the bound vertex array to this mesh
+  void bindAttributes() const;
+
+  GLuint getVertexArray() const { return vao; }
+  GLuint getVertexBuffer() const { return vbo; }
+  GLuint getIndexBuffer() const { return ibo; }
+  GLsizei getIndexCount() const { return indexCount; }
+  GLsizei getVertexCount() const { return vertexCount; }
+
+ private:
+  GLuint vao = 0;
+  GLuint vbo = 0;
+  GLuint ibo = 0;
+  GLsizei indexCount = 0;
+  GLsizei vertexCount = 0;
+};
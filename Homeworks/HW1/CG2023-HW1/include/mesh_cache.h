@@ -0,0 +1,82 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+#include "mesh.h"
+#include "utils.h"
+
+/// @brief Shapes known by the mesh generators in mesh.h
+enum class Primitive : uint8_t { Cylinder, Cuboid, Tetrahedron, Board };
+
+/// @brief Generator parameters, two primitives with equal keys have identical geometry.
+struct PrimitiveKey {
+  Primitive shape;
+  // Generator arguments in declaration order, unused ones are zero
+  std::array<float, 3> dimensions;
+  int segments;
+
+  bool operator==(const PrimitiveKey& other) const {
+    return shape == other.shape && dimensions == other.dimensions && segments == other.segments;
+  }
+};
+
+struct PrimitiveKeyHash {
+  std::size_t operator()(const PrimitiveKey& key) const;
+};
+
+/// @brief Run the mesh generator of key, CPU only
+MeshData generatePrimitive(const PrimitiveKey& key);
+
+/// @brief Immutable CPU and GPU copy of a generated primitive.
+struct PrimitiveMesh {
+  // Not copyable
+  DELETE_COPY(PrimitiveMesh)
+  // Not movable
+  DELETE_MOVE(PrimitiveMesh)
+  explicit PrimitiveMesh(MeshData&& _data) : data(std::move(_data)), mesh(data) {}
+
+  const MeshData data;
+  const Mesh mesh;
+};
+
+/// @brief Generate each distinct primitive once and share it between every user.
+class MeshCache final {
+ public:
+  using Handle = std::shared_ptr<const PrimitiveMesh>;
+  // Not copyable
+  DELETE_COPY(MeshCache)
+  // Not movable
+  DELETE_MOVE(MeshCache)
+  MeshCache() = default;
+  /// @brief Lookup a primitive, generate and upload it on the first request. Needs a current OpenGL context.
+  Handle get(const PrimitiveKey& key);
+
+  Handle cylinder(float radius, float height, int segments) {
+    return get({Primitive::Cylinder, {radius, height, 0.0f}, segments});
+  }
+  Handle cuboid(float length, float width, float height) {
+    return get({Primitive::Cuboid, {length, width, height}, 0});
+  }
+  Handle tetrahedron(float bottomEdge, float height1, float height2) {
+    return get({Primitive::Tetrahedron, {bottomEdge, height1, height2}, 0});
+  }
+  Handle board(float halfSize) { return get({Primitive::Board, {halfSize, 0.0f, 0.0f}, 0}); }
+
+  /// @brief Drop cached meshes, handles still in use stay valid
+  void clear() { meshes.clear(); }
+  /// @return Number of distinct primitives in the cache
+  std::size_t size() const { return meshes.size(); }
+  /// @return Number of requests served without generating geometry
+  std::size_t getHitCount() const { return hitCount; }
+  /// @return Number of requests that generated geometry
+  std::size_t getMissCount() const { return missCount; }
+
+ private:
+  std::unordered_map<PrimitiveKey, Handle, PrimitiveKeyHash> meshes;
+  std::size_t hitCount = 0;
+  std::size_t missCount = 0;
+};
@@ -1,4 +1,6 @@
 #pragma once
+#include <string>
+
 #include <GLFW/glfw3.h>
 #include <glad/gl.h>
 
@@ -18,9 +20,13 @@ class OpenGLContext final {
    * @param GLversion Minimal version of OpenGL context, (pass 41 if you want OpenGL 4.1 context)
    * @param profile OpenGL profile, can be one of GLFW_OPENGL_CORE_PROFILE, GLFW_OPENGL_ANY_PROFILE or
    * GLFW_OPENGL_COMPAT_PROFILE. Note that for GLversion < 32, you should always use GLFW_OPENGL_ANY_PROFILE
+   * @param headless Render into an invisible window through OSMesa, no display or GPU is needed when GLFW is built
+   * with GLFW_USE_OSMESA
    *
    */
-  static void createContext(int GLversion, int profile);
+  static void createContext(int GLversion, int profile, bool headless = false);
+  /// @return True if the context renders offscreen through OSMesa
+  static bool isHeadless() { return headless; }
   /// @return Current window handle.
   static GLFWwindow* getWindow() { return window; }
   /// @return Refresh rate of the primary monitor.
@@ -29,6 +35,8 @@ class OpenGLContext final {
   static int getWidth() { return framebuffer_width; }
   /// @return Current framebuffer height
   static int getHeight() { return framebuffer_height; }
+  /// @brief glfwSwapInterval, 0 disables vsync
+  static void setSwapInterval(int interval);
   /// @return Current framebuffer aspect ratio
   static float getAspectRatio() { return static_cast<float>(framebuffer_width) / framebuffer_height; }
   /// @brief Enable OpenGL's debug callback
@@ -37,12 +45,19 @@ class OpenGLContext final {
   static void framebufferResizeCallback(GLFWwindow* _window, int width, int height);
   /// @brief Enable OpenGL's debug callback, useful for debugging.
   static void enableDebugCallback();
+  /**
+   * @brief Save the back buffer as a binary PPM image, call it before swapping buffers.
+   *
+   * @throw std::runtime_error if the file cannot be written
+   */
+  static void saveFramebuffer(const std::string& path);
 
  private:
   /// @brief Create OpenGL context, call by createContext method
   OpenGLContext();
   static int major_version, minor_version;
   static int profile;
+  static bool headless;
   // Cached data
   static GLFWwindow* window;
   static int refresh_rate;
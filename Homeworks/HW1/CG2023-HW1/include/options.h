@@ -0,0 +1,113 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/// @brief How the scene is submitted to OpenGL.
+enum class RenderPath {
+  // glBegin/glEnd, vertices are sent one call at a time every frame, needs a compatibility profile
+  Immediate,
+  // Meshes are built once into VAO + VBO + IBO, one glDrawElements per part
+  Retained,
+  // Meshes are shared by all airplanes, one glDrawElementsInstanced per part
+  Instanced,
+};
+
+/// @brief When frames are presented, see FramePacer.
+enum class PacingMode {
+  // Swap interval 1, wait for every vertical blank
+  VSync,
+  // Swap interval -1, late frames tear instead of waiting a whole refresh, falls back to VSync where unsupported
+  Adaptive,
+  // Swap interval 0, as fast as possible
+  Uncapped,
+  // Swap interval 0 and a software limiter holding targetFps
+  Limit,
+};
+
+/// @brief Camera shown in a viewport of --views, see SplitScreen.
+enum class ViewKind {
+  // Driven by the mouse and WASD
+  Main,
+  // Behind and above the lead airplane, turns with it
+  Chase,
+  // Straight down on the lead airplane
+  Overhead,
+  // From the nose of the lead airplane along its heading
+  Cockpit,
+};
+
+// Most viewports of --views
+#define MAX_VIEW_COUNT 4
+
+/// @brief Startup options, parsed once from the command line.
+struct Options {
+  RenderPath renderPath = RenderPath::Retained;
+  // Number of airplanes in the scene
+  int instanceCount = 1;
+  // Render offscreen through OSMesa, also enabled by a non-empty HW1_HEADLESS other than "0"
+  bool headless = false;
+  // Stop after this many frames, 0 runs until the window is closed
+  int frameCount = 0;
+  // Save the last frame as a PPM image when not empty
+  std::string capturePath;
+  // Write a benchmark report as JSON when not empty
+  std::string jsonPath;
+  // Step the simulation on its own thread instead of at the start of each frame
+  bool simulationThread = true;
+#ifdef HW1_BENCHMARK
+  // Measure rendering, not the refresh rate of the monitor
+  PacingMode pacing = PacingMode::Uncapped;
+#else
+  PacingMode pacing = PacingMode::VSync;
+#endif
+  // Frame rate held by PacingMode::Limit
+  int targetFps = 60;
+  // Only redraw when the picture changes, wait for events otherwise
+  bool idle = false;
+  // Infinite reverse-Z projection, needs OpenGL 4.5 or GL_ARB_clip_control
+  bool reverseZ = false;
+  // Viewports drawn each frame, in grid order
+  std::vector<ViewKind> views = {ViewKind::Main};
+  // Both eyes side by side in every viewport, drawn in a single pass
+  bool stereo = false;
+  // Distance between the eyes in scene units
+  float ipd = 0.065f;
+  // Levels of detail switch at 2^lodBias times the projected size, positive values keep finer fuselages
+  float lodBias = 0.0f;
+  // Write every input to this file when not empty
+  std::string recordPath;
+  // Take input from a file of --record instead of the devices when not empty, steps the simulation inline
+  std::string replayPath;
+};
+
+/**
+ * @brief Parse command line arguments.
+ *
+ * Supported arguments:
+ *   --renderer=immediate|retained|instanced
+ *   --instances=N        1 <= N <= MAX_AIRPLANE_COUNT
+ *   --headless           render offscreen through OSMesa
+ *   --frames=N           stop after N frames, 0 (default) runs until the window is closed
+ *   --capture=PATH       save the last frame to PATH as a PPM image, needs --frames
+ *   --json=PATH          write a benchmark report of the run to PATH
+ *   --simulation=inline|thread  step the simulation in the frame loop or on its own thread (default)
+ *   --pacing=vsync|adaptive|uncapped|limit  vsync is the default, uncapped in HW1_bench
+ *   --fps=N              1 <= N <= 1000, frame rate of --pacing=limit, 60 by default
+ *   --idle               redraw only when the camera, the airplanes or the window change, not with --frames
+ *   --reverse-z          infinite reverse-Z projection, no far plane
+ *   --views=KIND,...     up to MAX_VIEW_COUNT viewports of main|chase|overhead|cockpit, main by default
+ *   --stereo             draw both eyes side by side in one pass, needs --renderer=retained|instanced
+ *   --ipd=X              0 <= X <= 10, distance between the eyes of --stereo, 0.065 by default
+ *   --lod-bias=X         -4 <= X <= 4, shift the fuselage levels of detail, positive is finer, 0 by default
+ *   --record=PATH        write every key, cursor and resize input to PATH
+ *   --replay=PATH        play back a recording at one simulation step per frame, ends with it unless --frames is given
+ *
+ * @throw std::invalid_argument if an argument is unknown or malformed
+ */
+Options parseOptions(int argc, char** argv);
+/// @return Printable name of the render path
+const char* toString(RenderPath path);
+/// @return Printable name of the pacing mode, same as its --pacing value
+const char* toString(PacingMode mode);
+/// @return Printable name of the view, same as its --views value
+const char* toString(ViewKind kind);
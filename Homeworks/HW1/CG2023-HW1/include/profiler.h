@@ -0,0 +1,39 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "utils.h"
+
+/**
+ * @brief Scoped CPU timers, use PROFILE_SCOPE from utils.h instead of this header.
+ *
+ * Each thread writes into its own ring buffer without locks, the oldest events are overwritten when a buffer is full.
+ * Only compiled when ENABLE_PROFILER is defined (CMake option HW1_ENABLE_PROFILER).
+ */
+namespace profiler {
+/// @return Nanoseconds since the profiler started
+uint64_t now();
+/// @brief Append a finished scope to the ring buffer of the calling thread, name must outlive the profiler
+void record(const char* name, uint64_t start, uint64_t end);
+/**
+ * @brief Write every buffered event as Chrome trace JSON, open it in about:tracing or ui.perfetto.dev.
+ *
+ * Can be called while other threads are recording, events they overwrite during the dump are left out.
+ * @return False if the file cannot be written
+ */
+bool writeChromeTrace(const std::string& path);
+
+/// @brief Records the lifetime of the scope it is declared in
+class Scope final {
+ public:
+  DELETE_COPY(Scope)
+  DELETE_MOVE(Scope)
+  explicit Scope(const char* name) : name(name), start(now()) {}
+  ~Scope() { record(name, start, now()); }
+
+ private:
+  const char* name;
+  uint64_t start;
+};
+}  // namespace profiler
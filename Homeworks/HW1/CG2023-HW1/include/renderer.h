@@ -0,0 +1,203 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "airplane.h"
+#include "camera.h"
+#include "frustum_culler.h"
+#include "gpu_timer.h"
+#include "lod_selector.h"
+#include "matrix_stack.h"
+#include "mesh_cache.h"
+#include "shader.h"
+#include "utils.h"
+
+// Per-instance generic attribute locations
+constexpr GLuint INSTANCE_OFFSET_ATTRIBUTE = 2;
+constexpr GLuint INSTANCE_COLOR_ATTRIBUTE = 3;
+
+/// @brief One airplane as uploaded to the instance buffer.
+struct InstanceData {
+  // Airplane origin relative to the camera of its view, subtracted in double precision before it is narrowed
+  glm::vec3 offset;
+  // Tint multiplied with the part colors, normalized unsigned bytes
+  glm::u8vec4 color;
+};
+
+/// @brief Layout of the std140 uniform block "Scene" of the Blinn-Phong program.
+struct SceneUniforms {
+  glm::mat4 view;
+  glm::mat4 projection;
+  // Light relative to the camera, LIGHT_POSITION in world space like light() in main.cpp
+  glm::vec4 lightPosition;
+  glm::vec4 lightAmbient;
+  glm::vec4 lightDiffuse;
+  glm::vec4 lightSpecular;
+  // Global ambient, GL_LIGHT_MODEL_AMBIENT in the fixed function pipeline
+  glm::vec4 sceneAmbient;
+  // Ambient and diffuse come from the vertex color like glColorMaterial, w is the shininess
+  glm::vec4 materialSpecular;
+};
+
+/// @brief A viewport of the frame, the camera it shows, the airplanes visible from it and their levels of detail.
+struct RenderView {
+  const Camera* camera;
+  const FrustumCuller* culler;
+  const LodSelector* lod;
+};
+
+/// @brief Core profile Blinn-Phong program and its uniform buffer.
+class SceneProgram final {
+ public:
+  // Not copyable
+  DELETE_COPY(SceneProgram)
+  // Not movable
+  DELETE_MOVE(SceneProgram)
+  /// @brief Compile the program and upload the light and material, needs a current OpenGL context
+  SceneProgram();
+  /// @brief Release the uniform buffer
+  ~SceneProgram();
+  /// @brief Give each of count views its own copy of the uniforms, so switching views uploads nothing
+  void reserveViews(std::size_t count);
+  /// @brief Bind the program and the uniforms of view, upload the camera matrices and light if the camera changed
+  void use(const Camera& camera, std::size_t view = 0);
+  /// @brief Left-most transform, the vertex shader computes modelView * (partModel * position + instanceOffset)
+  void setModelView(const float* modelView) const;
+  /// @brief Draw count eyes ipd apart per instance, 1 for a single eye at the camera
+  void setEyes(int count, float ipd);
+  /// @brief Right-most transform and color of the part drawn next
+  void setPart(const glm::mat4& model, const glm::vec3& color) const;
+  void setPartColor(const glm::vec3& color) const;
+  /// @brief Instance attributes for draws without an instance buffer
+  void setInstance(const glm::vec3& offset, const glm::vec4& color) const;
+  void setInstanceColor(const glm::vec4& color) const;
+
+ private:
+  ShaderProgram program;
+  GLint modelViewLocation;
+  GLint partModelLocation;
+  GLint partColorLocation;
+  GLint eyeCountLocation;
+  GLint eyeOffsetsLocation;
+  GLuint uniformBuffer = 0;
+  // Bytes between the uniforms of two views, a multiple of GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+  GLsizeiptr viewStride = 0;
+  // Camera version currently in the uniforms of each view, 0 is never handed out
+  std::vector<uint64_t> uploadedCameraVersions;
+};
+
+/// @brief Mesh based render path, draws the board and the fleet with the Blinn-Phong program.
+class Renderer {
+ public:
+  // Not copyable
+  DELETE_COPY(Renderer)
+  // Not movable
+  DELETE_MOVE(Renderer)
+  virtual ~Renderer() = default;
+  /**
+   * @brief Work shared by every view of a frame, call once before render().
+   *
+   * Keeps the views and raises the wings of flight, InstancedRenderer also uploads the visible airplanes of every
+   * view. The cullers must have culled for this frame.
+   */
+  virtual void beginFrame(const FlightState& flight, const std::vector<RenderView>& views);
+  /// @brief Draw the scene seen from the view-th view given to beginFrame into the current viewport
+  virtual void render(std::size_t view) = 0;
+  /**
+   * @brief Draw both eyes of every view in the same draw calls, left and right half of the viewport.
+   *
+   * Each draw runs twice as many instances, the vertex shader picks the eye from gl_InstanceID, moves the view by
+   * half of ipd and clips the eye to its half. Projections must be made for half of the viewport width.
+   */
+  virtual void setStereo(float ipd);
+  /// @brief Mark the board and airplane passes on timer, nullptr to stop
+  void setGpuTimer(GpuTimer* timer) { gpuTimer = timer; }
+
+ protected:
+  /// @brief Fetch all meshes from the cache, needs a current OpenGL context
+  explicit Renderer(MeshCache& cache);
+  /// @brief Draw the board at the world origin, the program must be in use and the top of stack the view matrix
+  void renderBoard(const Camera& camera);
+
+  SceneProgram program;
+  // Composes the model view matrix of each draw on the CPU
+  MatrixStack stack;
+  MeshCache::Handle board;
+  std::vector<AirplanePart> parts;
+  // Parts at each level of detail, only the fuselage mesh differs
+  std::array<std::vector<AirplanePart>, LOD_LEVEL_COUNT> levelParts;
+  // Flight and views of this frame, see beginFrame()
+  FlightState flight;
+  std::vector<RenderView> views;
+  // Transform of each part in airplane space, the flight heading times the part with raised wings, the same for
+  // every view
+  std::vector<glm::mat4> partTransforms;
+  // Instances per drawn object, 2 in stereo
+  int eyeCount = 1;
+  GpuTimer* gpuTimer = nullptr;
+};
+
+/// @brief One glDrawElements per part and visible airplane.
+class RetainedRenderer final : public Renderer {
+ public:
+  /// @param fleet Airplanes to draw, must outlive the renderer, cullers of the views index into it
+  RetainedRenderer(MeshCache& cache, const std::vector<AirplaneInstance>& fleet);
+  void render(std::size_t view) override;
+
+ private:
+  const std::vector<AirplaneInstance>& fleet;
+};
+
+/// @brief One glDrawElementsInstanced per airplane part for the visible part of the fleet.
+class InstancedRenderer final : public Renderer {
+ public:
+  /// @brief Upload the fleet, needs a current OpenGL context
+  /// @param fleet Airplanes to draw, must outlive the renderer, cullers of the views index into it
+  InstancedRenderer(MeshCache& cache, const std::vector<AirplaneInstance>& fleet);
+  /// @brief Release OpenGL objects
+  ~InstancedRenderer() override;
+  /// @brief Also makes every airplane of the instance buffer last one instance per eye
+  void setStereo(float ipd) override;
+  /// @brief Also packs the visible airplanes of every view into the instance buffer, one upload for all views
+  void beginFrame(const FlightState& flight, const std::vector<RenderView>& views) override;
+  void render(std::size_t view) override;
+
+ private:
+  /// @brief First instance and instance count in visibleInstances
+  struct InstanceRange {
+    std::size_t first = 0;
+    GLsizei count = 0;
+  };
+  /// @brief Instances of one view, the levels of detail are consecutive ranges of all
+  struct ViewInstances {
+    InstanceRange all;
+    std::array<InstanceRange, LOD_LEVEL_COUNT> levels;
+  };
+  /// @brief Bind vertexArray with its instance attributes pointing at the instance first of the buffer
+  void bindInstances(GLuint vertexArray, std::size_t first);
+  /// @brief Draw range of the instance buffer with part through vertexArray
+  void drawInstances(GLuint vertexArray, const AirplanePart& part, const InstanceRange& range);
+
+  // Vertex arrays combine the mesh buffers with the instance buffer, one per part and level, parts that are the
+  // same at every level share the vertex array of level 0
+  std::array<std::vector<GLuint>, LOD_LEVEL_COUNT> partVertexArrays;
+  // Instance the attributes of each distinct vertex array start at
+  std::unordered_map<GLuint, std::size_t> boundFirstInstances;
+  GLuint instanceBuffer = 0;
+  // Instances the buffer has room for
+  std::size_t instanceCapacity = 0;
+  const std::vector<AirplaneInstance>& fleet;
+  // Visible instances of every view are packed here relative to the camera of the view, one view after the other,
+  // sorted by level of detail, and uploaded when a culler or a level changed. A culler changes whenever the camera
+  // or the flight moves, so the offsets are never stale
+  std::vector<InstanceData> visibleInstances;
+  std::vector<ViewInstances> viewInstances;
+  // Culler and level of detail versions of the uploaded views
+  std::vector<std::pair<uint64_t, uint64_t>> uploadedVersions;
+};
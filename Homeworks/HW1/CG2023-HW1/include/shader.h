@@ -0,0 +1,30 @@
+#pragma once
+#include <glad/gl.h>
+
+#include "gl_state_cache.h"
+#include "utils.h"
+
+/// @brief Vertex + fragment shader program compiled from source strings.
+class ShaderProgram final {
+ public:
+  // Not copyable
+  DELETE_COPY(ShaderProgram)
+  // Not movable, owns an OpenGL object
+  DELETE_MOVE(ShaderProgram)
+  /**
+   * @brief Compile and link a program, needs a current OpenGL context.
+   *
+   * @throw std::runtime_error with the info log if compiling or linking fails
+   */
+  ShaderProgram(const char* vertexSource, const char* fragmentSource);
+  /// @brief Release the program
+  ~ShaderProgram();
+  /// @brief Bind the program for the following draw calls
+  void use() const { GLStateCache::useProgram(program); }
+  /// @return Location of the uniform, -1 if it does not exist or was optimized out
+  GLint getUniformLocation(const char* name) const { return glGetUniformLocation(program, name); }
+  GLuint getProgram() const { return program; }
+
+ private:
+  GLuint program = 0;
+};
@@ -0,0 +1,128 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include "airplane.h"
+#include "camera.h"
+#include "triple_buffer.h"
+#include "utils.h"
+
+// Airplane speed per simulation step, degrees for turning and distance for flying
+#define ROTATE_SPEED 1.0f
+#define FLYING_SPEED ROTATE_SPEED / 20.f
+// Wings flap between +-MAX_WING_ANGLE degrees while flying, WING_FLAP_SPEED degrees per step
+#define MAX_WING_ANGLE 30.0f
+#define WING_FLAP_SPEED 4.0f * ROTATE_SPEED
+// TODO (optional): Change this value if your WASD move too slow or too fast, units per second.
+#define CAMERA_MOVE_SPEED 6.0f
+
+/// @brief Keys held when the frame sampled input, steps read nothing else from outside.
+struct SimulationInput {
+  // Unit direction of WASD in world space, zero when no key is held
+  glm::vec3 cameraDirection = glm::vec3(0.0f);
+  // SPACE flies up and forward and flaps the wings, the arrow keys turn
+  bool fly = false;
+  bool turnLeft = false;
+  bool turnRight = false;
+
+  /// @return True if any key that moves something is held
+  bool isActive() const;
+};
+
+/// @brief Held state of every GLFW key code
+using KeyState = std::array<bool, GLFW_KEY_LAST + 1>;
+
+/// @return Input of the keys held, WASD moves along the axes of camera
+SimulationInput sampleInput(const KeyState& keys, const Camera& camera);
+
+/// @brief Everything the simulation advances.
+struct SimulationState {
+  // World position
+  glm::dvec3 cameraPosition = glm::dvec3(0.0);
+  FlightState flight;
+};
+
+/// @return State between a (alpha 0) and b (alpha 1)
+SimulationState interpolate(const SimulationState& a, const SimulationState& b, float alpha);
+
+/**
+ * @brief Advances the world in fixed steps of STEP seconds, independent of the frame rate.
+ *
+ * Each frame adds the time since the previous one to an accumulator and runs as many steps as fit. Rendering uses the
+ * state between the last two steps at the fraction of a step left over, so results do not depend on the frame rate
+ * and the rendered state is at most one step behind.
+ */
+class Simulation final {
+ public:
+  static constexpr double STEP = 1.0 / 60.0;
+  // Steps one frame may run, time beyond is dropped so a long stall does not stall the next frames too
+  static constexpr int MAX_STEPS_PER_FRAME = 8;
+
+  /// @param time glfwGetTime() the simulation starts at
+  Simulation(const SimulationState& initial, double time);
+
+  /// @brief Run the steps due at time with input held during all of them, @return Steps run
+  int advance(const SimulationInput& input, double time);
+  /// @return State to render, interpolated between the last two steps
+  SimulationState getRenderState() const;
+  /// @return False if the last step changed nothing, later steps without input will not either
+  bool isMoving() const;
+  uint64_t getStepCount() const { return stepCount; }
+
+  /// @brief Advance state by STEP seconds
+  static void step(SimulationState& state, const SimulationInput& input);
+
+ private:
+
+  SimulationState previous;
+  SimulationState current;
+  double lastTime;
+  // Time not yet simulated, less than STEP after advance()
+  double accumulator = 0.0;
+  uint64_t stepCount = 0;
+};
+
+/**
+ * @brief Runs the steps of Simulation on its own thread, in real time.
+ *
+ * The render thread hands over the keys held and takes the latest two steps through triple buffers, so neither thread
+ * ever waits for the other. Frames interpolate between the two steps by the time they sample, one step behind.
+ */
+class SimulationThread final {
+ public:
+  DELETE_COPY(SimulationThread)
+  DELETE_MOVE(SimulationThread)
+  /// @brief Start stepping from initial at time
+  SimulationThread(const SimulationState& initial, double time);
+  /// @brief Stop and join the thread
+  ~SimulationThread();
+
+  /// @brief Keys held from now on, render thread only
+  void setInput(const SimulationInput& input);
+  /// @return State to render at time, interpolated between the latest two steps, render thread only
+  SimulationState getRenderState(double time);
+  /// @return False if the latest step changed nothing, render thread only
+  bool isMoving();
+  uint64_t getStepCount() const { return stepCount.load(std::memory_order_relaxed); }
+
+ private:
+  /// @brief The last two steps and the time the newest one is due
+  struct Snapshot {
+    SimulationState previous;
+    SimulationState current;
+    double time = 0.0;
+  };
+  /// @brief Thread body, one step every STEP seconds until stopped
+  void run(SimulationState state, double time);
+
+  TripleBuffer<SimulationInput> input;
+  TripleBuffer<Snapshot> snapshots;
+  std::atomic<uint64_t> stepCount{0};
+  std::atomic<bool> running{true};
+  std::thread thread;
+};
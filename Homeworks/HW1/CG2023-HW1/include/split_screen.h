@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "airplane.h"
+#include "camera.h"
+#include "frustum_culler.h"
+#include "lod_selector.h"
+#include "options.h"
+#include "utils.h"
+
+/**
+ * @brief Viewports of the window laid out on a grid, each with its own camera, frustum culler and levels of detail.
+ *
+ * ViewKind::Main shows the camera driven by the mouse and WASD, the other kinds own a camera that follows the lead
+ * airplane, the first of the fleet. One view fills the window, more views are laid out two per row, top to bottom.
+ * Stereo views show two eyes side by side, the projections are made for half of the viewport.
+ */
+class SplitScreen final {
+ public:
+  /// @brief One viewport and what is visible in it
+  struct View {
+    ViewKind kind;
+    // The main camera, or follower
+    Camera* camera;
+    std::unique_ptr<Camera> follower;
+    FrustumCuller culler;
+    LodSelector lod;
+    // x, y, width, height in framebuffer pixels, y from the bottom like glViewport
+    glm::ivec4 viewport = glm::ivec4(0);
+    // CPU seconds spent culling and drawing the view since the last takeCpuTime()
+    double cpuTime = 0.0;
+  };
+
+  // Views point to each other's cameras
+  DELETE_COPY(SplitScreen)
+  DELETE_MOVE(SplitScreen)
+  /// @param main Camera of ViewKind::Main, must outlive the views
+  /// @param fleet Airplanes culled by every view, must outlive the views
+  SplitScreen(const std::vector<ViewKind>& kinds, Camera& main, const std::vector<AirplaneInstance>& fleet,
+              const BoundingSphere& bounds, bool stereo = false);
+
+  /// @brief Lay the views out on a framebuffer of width x height and update their projections
+  void resize(int width, int height);
+  /// @brief Update the projections for a framebuffer of width x height, the viewports stay, used by replays
+  void updateProjections(int width, int height);
+  /// @brief Move the follower cameras after the lead airplane of flight
+  void follow(const FlightState& flight);
+
+  Camera& getMainCamera() { return main; }
+  std::vector<View>& getViews() { return views; }
+  const std::vector<View>& getViews() const { return views; }
+
+ private:
+  /// @return Columns and rows of the grid
+  glm::ivec2 gridSize() const;
+
+  Camera& main;
+  std::vector<View> views;
+  bool stereo;
+  // Position of the lead airplane in the fleet, before the flight moves it
+  glm::dvec3 leadOffset;
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "utils.h"
+
+/**
+ * @brief Hands the newest value from one writer thread to one reader thread without locks.
+ *
+ * The writer fills its own buffer and publishes it by swapping it with the shared one, the reader takes the shared
+ * buffer by swapping it with its own. Neither side waits, the reader always sees a complete value and values it did
+ * not get to in time are skipped.
+ */
+template <typename T>
+class TripleBuffer final {
+ public:
+  DELETE_COPY(TripleBuffer)
+  DELETE_MOVE(TripleBuffer)
+  explicit TripleBuffer(const T& initial = T()) : buffers{initial, initial, initial} {}
+
+  /// @brief Writer side, the buffer to fill before publish()
+  T& write() { return buffers[writeIndex]; }
+  /// @brief Writer side, make the filled buffer the newest value
+  void publish() { writeIndex = shared.exchange(writeIndex | FRESH, std::memory_order_acq_rel) & INDEX_MASK; }
+  /// @brief Reader side, @return Newest published value, stays valid until the next read()
+  const T& read() {
+    if (shared.load(std::memory_order_relaxed) & FRESH) {
+      readIndex = shared.exchange(readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+    return buffers[readIndex];
+  }
+
+ private:
+  // The shared index carries a flag telling the reader it was published after its last read
+  static constexpr uint8_t INDEX_MASK = 3;
+  static constexpr uint8_t FRESH = 4;
+  std::array<T, 3> buffers;
+  std::atomic<uint8_t> shared{1};
+  uint8_t writeIndex = 0;
+  uint8_t readIndex = 2;
+};
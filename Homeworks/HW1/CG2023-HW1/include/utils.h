@@ -60,6 +60,22 @@
 #endif  // __cplusplus >= 202002L
 #endif  // HAS_CXX20_SUPPORT
 
+// Scoped CPU timers, PROFILE_SCOPE("name") times the enclosing scope and PROFILE_DUMP(path) writes a Chrome trace.
+// Both compile to nothing unless ENABLE_PROFILER is defined.
+#ifndef PROFILE_SCOPE
+#ifdef ENABLE_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) const profiler::Scope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_DUMP(path) profiler::writeChromeTrace(path)
+#else
+#define PROFILE_SCOPE(name) \
+  do {                      \
+  } while (false)
+#define PROFILE_DUMP(path) false
+#endif  // ENABLE_PROFILER
+#endif  // PROFILE_SCOPE
+
 // Some useful C++ 20 feature
 #ifndef CONSTEXPR_VIRTUAL
 #if HAS_CXX20_SUPPORT
@@ -82,9 +98,37 @@ constexpr inline T PI_2() {
   return static_cast<T>(M_PI_2);
 }
 
+/// @brief sin usable in constant expressions, accurate to ~1e-13 (Taylor series after reducing x to [-pi, pi])
+constexpr inline double sin(double x) {
+  while (x > PI<double>()) x -= 2 * PI<double>();
+  while (x < -PI<double>()) x += 2 * PI<double>();
+  double term = x, sum = x;
+  for (int n = 1; n < 13; ++n) {
+    term *= -x * x / ((2 * n) * (2 * n + 1));
+    sum += term;
+  }
+  return sum;
+}
+
+/// @brief cos usable in constant expressions, accurate to ~1e-13 (Taylor series after reducing x to [-pi, pi])
+constexpr inline double cos(double x) {
+  while (x > PI<double>()) x -= 2 * PI<double>();
+  while (x < -PI<double>()) x += 2 * PI<double>();
+  double term = 1, sum = 1;
+  for (int n = 1; n < 13; ++n) {
+    term *= -x * x / ((2 * n - 1) * (2 * n));
+    sum += term;
+  }
+  return sum;
+}
+
 #if HAS_CXX20_SUPPORT
 constexpr inline uint32_t log2(uint32_t n) { return std::bit_width(n) - 1; }
 #else
 constexpr inline uint32_t log2(uint32_t n) { return (n > 0) ? 1 + log2(n >> 1) : 0; }
 #endif  // HAS_CXX20_SUPPORT
 }  // namespace utils
+
+#ifdef ENABLE_PROFILER
+#include "profiler.h"
+#endif  // ENABLE_PROFILER
@@ -0,0 +1,42 @@
+#!/bin/bash
+# Run HW1_bench for every renderer and instance count, then merge the reports into one JSON array.
+# Usage: script/bench.sh [output.json] [extra HW1_bench arguments...]
+if [[ !(-d src) ]]; then
+  cd ..
+fi
+
+if [[ !(-x bin/HW1_bench) ]]; then
+  echo "Please build the HW1_bench target first."
+  exit 1
+fi
+
+output="${1:-bench.json}"
+shift
+renderers="${RENDERERS:-immediate retained instanced}"
+instances="${INSTANCES:-1 100 10000}"
+reports=$(mktemp -d)
+
+cd bin
+index=0
+for renderer in $renderers; do
+  for count in $instances; do
+    echo "Running $renderer x$count"
+    if ! ./HW1_bench --renderer="$renderer" --instances="$count" --json="$reports/$index.json" "$@" > /dev/null; then
+      echo "$renderer x$count failed"
+      exit 1
+    fi
+    index=$((index + 1))
+  done
+done
+cd ..
+
+{
+  echo "["
+  for ((i = 0; i < index; i++)); do
+    [[ $i -gt 0 ]] && echo ","
+    cat "$reports/$i.json"
+  done
+  echo "]"
+} > "$output"
+rm -r "$reports"
+echo "Wrote $output"
@@ -0,0 +1,99 @@
+#include "airplane.h"
+
+#include <cmath>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+/// @brief Generator parameters of a part, resolved to a mesh by the cache
+struct PartShape {
+  PrimitiveKey key;
+  glm::mat4 transform;
+  glm::vec3 color;
+  float wingSide;
+};
+
+// Wings turn around the body axis, x = 0, y = 0.5
+constexpr glm::vec3 WING_PIVOT(0.0f, 0.5f, 0.0f);
+
+std::vector<PartShape> airplaneShapes(int bodySegments = CIRCLE_SEGMENT) {
+  const glm::mat4 identity(1.0f);
+  return {
+      {{Primitive::Cylinder, {BODY_RADIUS, 4.0f, 0.0f}, bodySegments},
+       glm::rotate(glm::translate(identity, glm::vec3(0.0f, 0.5f, 0.0f)), glm::radians(-90.0f), glm::vec3(1, 0, 0)),
+       glm::vec3(BLUE), 0.0f},
+      {{Primitive::Cuboid, {4.0f, 1.0f, 0.5f}, 0}, glm::translate(identity, glm::vec3(2.0f, 0.5f, 0.0f)),
+       glm::vec3(RED), 1.0f},
+      {{Primitive::Cuboid, {4.0f, 1.0f, 0.5f}, 0}, glm::translate(identity, glm::vec3(-2.0f, 0.5f, 0.0f)),
+       glm::vec3(RED), -1.0f},
+      {{Primitive::Tetrahedron, {2.0f, 1.0f, 0.5f}, 0}, glm::translate(identity, glm::vec3(0.0f, 0.5f, 2.0f)),
+       glm::vec3(GREEN), 0.0f},
+  };
+}
+}  // namespace
+
+std::vector<AirplanePart> makeAirplaneParts(MeshCache& cache, int bodySegments) {
+  std::vector<AirplanePart> parts;
+  for (const PartShape& shape : airplaneShapes(bodySegments)) {
+    parts.push_back({cache.get(shape.key), shape.transform, shape.color, shape.wingSide});
+  }
+  return parts;
+}
+
+glm::mat4 FlightState::getRotation() const {
+  return glm::rotate(glm::mat4(1.0f), glm::radians(heading), glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+bool FlightState::operator==(const FlightState& other) const {
+  return position == other.position && heading == other.heading && wingAngle == other.wingAngle &&
+         flapDirection == other.flapDirection;
+}
+
+FlightState interpolate(const FlightState& a, const FlightState& b, float alpha) {
+  FlightState state;
+  state.position = glm::mix(a.position, b.position, static_cast<double>(alpha));
+  state.heading = glm::mix(a.heading, b.heading, alpha);
+  state.wingAngle = glm::mix(a.wingAngle, b.wingAngle, alpha);
+  state.flapDirection = b.flapDirection;
+  return state;
+}
+
+glm::mat4 partTransform(const AirplanePart& part, float wingAngle) {
+  if (part.wingSide == 0.0f || wingAngle == 0.0f) return part.transform;
+  glm::mat4 flap = glm::translate(glm::mat4(1.0f), WING_PIVOT);
+  flap = glm::rotate(flap, glm::radians(part.wingSide * wingAngle), glm::vec3(0.0f, 0.0f, 1.0f));
+  return glm::translate(flap, -WING_PIVOT) * part.transform;
+}
+
+BoundingSphere airplaneBoundingSphere() {
+  // Merge all parts into one vertex list, a sphere per part would only be looser
+  MeshData merged;
+  for (const PartShape& shape : airplaneShapes()) {
+    MeshData part = generatePrimitive(shape.key);
+    for (Vertex& vertex : part.vertices) vertex.position = glm::vec3(shape.transform * glm::vec4(vertex.position, 1));
+    merged.vertices.insert(merged.vertices.end(), part.vertices.begin(), part.vertices.end());
+  }
+  // The center lies on the wing axis, so raised wings keep their distance to it
+  return mesh::boundingSphere(merged);
+}
+
+std::vector<AirplaneInstance> makeFleet(int count) {
+  // Wing span is 8 and body length is 4, leave some room between airplanes
+  constexpr double spacingX = 10.0;
+  constexpr double spacingZ = 6.0;
+  std::vector<AirplaneInstance> fleet(count);
+  int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(count))));
+  for (int i = 0; i < count; ++i) {
+    int column = i % columns;
+    int row = i / columns;
+    fleet[i].position = glm::dvec3((column - (columns - 1) / 2.0) * spacingX, 0.0, -row * spacingZ);
+    // Cheap integer hash for a stable, varied tint
+    uint32_t hash = static_cast<uint32_t>(i) * 2654435761u;
+    if (i == 0) {
+      fleet[i].color = glm::u8vec4(255);
+    } else {
+      fleet[i].color = glm::u8vec4(160 + (hash >> 8) % 96, 160 + (hash >> 16) % 96, 160 + (hash >> 24) % 96, 255);
+    }
+  }
+  return fleet;
+}
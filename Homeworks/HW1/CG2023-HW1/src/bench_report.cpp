@@ -0,0 +1,87 @@
+#include "bench_report.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+/// @return Nearest rank percentile of sorted values, p in [0, 100]
+double percentile(const std::vector<double>& sorted, double p) {
+  std::size_t rank = static_cast<std::size_t>(std::ceil(p / 100.0 * sorted.size()));
+  return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+}
+
+void writeSummary(std::ostream& out, const char* name, std::vector<double> values) {
+  out << "\"" << name << "\": ";
+  if (values.empty()) {
+    out << "null";
+    return;
+  }
+  std::sort(values.begin(), values.end());
+  double mean = std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+  out << "{\"mean\": " << mean << ", \"p50\": " << percentile(values, 50) << ", \"p95\": " << percentile(values, 95)
+      << ", \"p99\": " << percentile(values, 99) << ", \"max\": " << values.back() << "}";
+}
+/// @brief Write mean, min and max of counts, null if there are none
+void writeRange(std::ostream& out, const char* name, const std::vector<uint64_t>& counts) {
+  out << "\"" << name << "\": ";
+  if (counts.empty()) {
+    out << "null";
+    return;
+  }
+  auto [min, max] = std::minmax_element(counts.begin(), counts.end());
+  double mean = std::accumulate(counts.begin(), counts.end(), 0.0) / counts.size();
+  out << "{\"mean\": " << mean << ", \"min\": " << *min << ", \"max\": " << *max << "}";
+}
+/// @brief Write the standard deviation of values, null if there are none
+void writeDeviation(std::ostream& out, const char* name, const std::vector<double>& values) {
+  out << "\"" << name << "\": ";
+  if (values.empty()) {
+    out << "null";
+    return;
+  }
+  double mean = std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+  double squares = 0.0;
+  for (double value : values) squares += (value - mean) * (value - mean);
+  out << std::sqrt(squares / values.size());
+}
+}  // namespace
+
+void BenchReport::addGpuFrame(const GpuTimer::FrameTimes& frame) {
+  gpuFrameTimes.push_back(frame.total);
+  for (int i = 0; i < GPU_PASS_COUNT; ++i) gpuPassTimes[i].push_back(frame.passes[i]);
+}
+
+void BenchReport::write(std::ostream& out) const {
+  out << "{\"renderer\": \"" << renderer << "\", \"instances\": " << instanceCount
+      << ", \"headless\": " << (headless ? "true" : "false") << ", \"pacing\": \"" << pacing
+      << "\", \"frames\": " << cpuFrameTimes.size() << ", ";
+  writeSummary(out, "cpu_ms", cpuFrameTimes);
+  out << ", ";
+  writeSummary(out, "gpu_ms", gpuFrameTimes);
+  out << ", \"gpu_passes_ms\": {";
+  for (int i = 0; i < GPU_PASS_COUNT; ++i) {
+    if (i > 0) out << ", ";
+    writeSummary(out, toString(static_cast<GpuPass>(i)), gpuPassTimes[i]);
+  }
+  out << "}, ";
+  writeSummary(out, "present_ms", presentIntervals);
+  out << ", ";
+  writeDeviation(out, "present_jitter_ms", presentIntervals);
+  out << ", ";
+  writeRange(out, "draw_calls", drawCalls);
+  out << ", ";
+  writeRange(out, "vertices", vertices);
+  out << ", \"airplanes_drawn\": " << airplanesDrawn << ", \"airplanes_culled\": " << airplanesCulled
+      << ", \"lod_segments\": {";
+  for (int level = 0; level < LOD_LEVEL_COUNT; ++level) {
+    out << (level > 0 ? ", " : "") << "\"" << LOD_SEGMENTS[level] << "\": " << lodLevelCounts[level];
+  }
+  out << "}, \"views\": [";
+  for (std::size_t i = 0; i < views.size(); ++i) {
+    out << (i > 0 ? ", " : "") << "{\"view\": \"" << views[i].name << "\", ";
+    writeSummary(out, "cpu_ms", views[i].cpuTimes);
+    out << ", \"airplanes_drawn\": " << views[i].airplanesDrawn << "}";
+  }
+  out << "]}" << std::endl;
+}
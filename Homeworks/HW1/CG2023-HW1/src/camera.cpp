@@ -1,52 +1,51 @@
 #include "camera.h"
 
-Camera::Camera(glm::vec3 _position)
+#include <cmath>
+
+#include <glm/gtc/quaternion.hpp>
+
+#include "utils.h"
+
+uint64_t Camera::lastVersion = 0;
+
+Camera::Camera(glm::dvec3 _position)
     : position(_position),
       up(0, 1, 0),
       front(0, 0, -1),
       right(1, 0, 0),
       rotation(glm::identity<glm::quat>()),
       projectionMatrix(1),
-      viewMatrix(1) {}
+      viewMatrix(1) {
+  updateDerivedMatrices();
+}
 
-void Camera::initialize(float aspectRatio) {
+void Camera::initialize(float aspectRatio, bool _reverseZ) {
+  reverseZ = _reverseZ;
   updateProjectionMatrix(aspectRatio);
   updateViewMatrix();
 }
 
-void Camera::move(GLFWwindow* window) {
+void Camera::move(double sampleTime) {
+  PROFILE_SCOPE("Camera::move");
   bool ismoved = false;
-  // Mouse part
-  static double lastx = 0, lasty = 0;
-  if (lastx == 0 && lasty == 0) {
-    glfwGetCursorPos(window, &lastx, &lasty);
-  } else {
-    double xpos, ypos;
-    glfwGetCursorPos(window, &xpos, &ypos);
-    float dx = mouseMoveSpeed * static_cast<float>(xpos - lastx);
-    float dy = mouseMoveSpeed * static_cast<float>(lasty - ypos);
-    lastx = xpos;
-    lasty = ypos;
-    if (dx != 0 || dy != 0) {
-      ismoved = true;
-      glm::quat rx(glm::angleAxis(dx, glm::vec3(0, -1, 0)));
-      glm::quat ry(glm::angleAxis(dy, glm::vec3(1, 0, 0)));
-      rotation = rx * rotation * ry;
-    }
+  // Mouse part, integrate the queued cursor motion up to the sample time
+  glm::dvec2 cursorDelta(0.0);
+  inputLatency = 0.0;
+  InputEvent event;
+  while (inputQueue.popUntil(sampleTime, event)) {
+    // The first position only sets the reference
+    if (hasCursor) cursorDelta += event.cursor - lastCursor;
+    if (inputLatency == 0.0) inputLatency = sampleTime - event.time;
+    lastCursor = event.cursor;
+    hasCursor = true;
   }
-  // Keyboard part
-  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
-    position += front * keyboardMoveSpeed;
-    ismoved = true;
-  } else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
-    position -= front * keyboardMoveSpeed;
-    ismoved = true;
-  } else if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
-    position -= right * keyboardMoveSpeed;
-    ismoved = true;
-  } else if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
-    position += right * keyboardMoveSpeed;
+  float dx = mouseMoveSpeed * static_cast<float>(cursorDelta.x);
+  float dy = mouseMoveSpeed * static_cast<float>(-cursorDelta.y);
+  if (dx != 0 || dy != 0) {
     ismoved = true;
+    glm::quat rx(glm::angleAxis(dx, glm::vec3(0, -1, 0)));
+    glm::quat ry(glm::angleAxis(dy, glm::vec3(1, 0, 0)));
+    rotation = rx * rotation * ry;
   }
   // Update view matrix if moved
   if (ismoved) {
@@ -54,6 +53,23 @@ void Camera::move(GLFWwindow* window) {
   }
 }
 
+void Camera::setPosition(const glm::dvec3& _position) {
+  if (_position == position) return;
+  position = _position;
+  // The view matrix does not depend on the position, but everything placed relative to the camera moved
+  updateDerivedMatrices();
+}
+
+void Camera::lookAt(const glm::dvec3& target, const glm::vec3& worldUp) {
+  glm::vec3 direction = toCameraRelative(target);
+  if (glm::length(direction) == 0.0f) return;
+  // Maps -z, the original front, to the direction
+  rotation = glm::quatLookAt(glm::normalize(direction), worldUp);
+  updateViewMatrix();
+}
+
+void Camera::onCursorPos(double x, double y, double time) { inputQueue.push({time, glm::dvec2(x, y)}); }
+
 void Camera::updateViewMatrix() {
   constexpr glm::vec3 original_front(0, 0, -1);
   constexpr glm::vec3 original_up(0, 1, 0);
@@ -74,13 +90,18 @@ void Camera::updateViewMatrix() {
   // Step 2: Calculate the right vector by taking the cross product
   glm::vec3 right = glm::cross(rotatedFront, rotatedUp);
 
-  // Step 3: Calculate the view matrix with the position
-  viewMatrix = glm::lookAt(position, position + rotatedFront, rotatedUp);
+  // Step 3: Calculate the view matrix, the position is applied by toCameraRelative() in double precision
+  glm::mat4 newViewMatrix = glm::lookAt(glm::vec3(0.0f), rotatedFront, rotatedUp);
+  if (newViewMatrix != viewMatrix) {
+    viewMatrix = newViewMatrix;
+    updateDerivedMatrices();
+  }
 }
 
 void Camera::updateProjectionMatrix(float aspectRatio) {
   constexpr float FOV = glm::radians(45.0f);
   constexpr float zNear = 0.1f;
+  // Keeps the far plane of the assignment, large fleets need --reverse-z to be seen past it
   constexpr float zFar = 100.0f;
   /* TODO#1-2: Calculate perspective projection matrix
    * Hint: You can calculate the matrix by hand, or use
@@ -89,5 +110,39 @@ void Camera::updateProjectionMatrix(float aspectRatio) {
    */
 
   // Calculate perspective projection matrix
-  projectionMatrix = glm::perspective(FOV, aspectRatio, zNear, zFar);
+  glm::mat4 newProjectionMatrix = glm::perspective(FOV, aspectRatio, zNear, zFar);
+  if (reverseZ) {
+    // Clip z is the constant zNear and w is -z, so depth zNear / -z goes from 1 at zNear to 0 at infinity
+    float focalLength = 1.0f / std::tan(FOV / 2.0f);
+    newProjectionMatrix = glm::mat4(0.0f);
+    newProjectionMatrix[0][0] = focalLength / aspectRatio;
+    newProjectionMatrix[1][1] = focalLength;
+    newProjectionMatrix[2][3] = -1.0f;
+    newProjectionMatrix[3][2] = zNear;
+  }
+  if (newProjectionMatrix != projectionMatrix) {
+    projectionMatrix = newProjectionMatrix;
+    updateDerivedMatrices();
+  }
+}
+
+void Camera::updateDerivedMatrices() {
+  viewProjectionMatrix = projectionMatrix * viewMatrix;
+  inverseViewProjectionMatrix = glm::inverse(viewProjectionMatrix);
+  // Gribb-Hartmann: clip space -w <= x, y, z <= w gives row 3 +- row i of projection * view
+  glm::mat4 rows = glm::transpose(viewProjectionMatrix);
+  for (int i = 0; i < 3; ++i) {
+    frustumPlanes[2 * i] = rows[3] + rows[i];
+    frustumPlanes[2 * i + 1] = rows[3] - rows[i];
+  }
+  if (reverseZ) {
+    // 0 <= z <= w, near is z <= w and the far plane is at infinity
+    frustumPlanes[4] = rows[3] - rows[2];
+    frustumPlanes[5] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+  }
+  for (glm::vec4& plane : frustumPlanes) {
+    float length = glm::length(glm::vec3(plane));
+    if (length > 0.0f) plane /= length;
+  }
+  version = ++lastVersion;
 }
\ No newline at end of file
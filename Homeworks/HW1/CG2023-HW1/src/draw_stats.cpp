@@ -0,0 +1,13 @@
+#include "draw_stats.h"
+
+uint64_t DrawStats::drawCallCount = 0;
+uint64_t DrawStats::vertexCount = 0;
+uint64_t DrawStats::lastDrawCallCount = 0;
+uint64_t DrawStats::lastVertexCount = 0;
+
+void DrawStats::beginFrame() { drawCallCount = vertexCount = 0; }
+
+void DrawStats::endFrame() {
+  lastDrawCallCount = drawCallCount;
+  lastVertexCount = vertexCount;
+}
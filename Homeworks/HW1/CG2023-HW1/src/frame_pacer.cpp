@@ -0,0 +1,58 @@
+#include "frame_pacer.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include <GLFW/glfw3.h>
+
+#include "opengl_context.h"
+
+FramePacer::FramePacer(PacingMode _mode, int targetFps) : mode(_mode), timerFrequency(glfwGetTimerFrequency()) {
+  if (mode == PacingMode::Adaptive && !glfwExtensionSupported("WGL_EXT_swap_control_tear") &&
+      !glfwExtensionSupported("GLX_EXT_swap_control_tear")) {
+    std::cerr << "Adaptive vsync is not supported, using vsync" << std::endl;
+    mode = PacingMode::VSync;
+  }
+  switch (mode) {
+    case PacingMode::VSync:
+      OpenGLContext::setSwapInterval(1);
+      break;
+    case PacingMode::Adaptive:
+      OpenGLContext::setSwapInterval(-1);
+      break;
+    case PacingMode::Uncapped:
+    case PacingMode::Limit:
+      OpenGLContext::setSwapInterval(0);
+      break;
+  }
+  period = timerFrequency / targetFps;
+}
+
+void FramePacer::waitForDeadline() {
+  if (mode != PacingMode::Limit) return;
+  PROFILE_SCOPE("FramePacer::waitForDeadline");
+  uint64_t now = glfwGetTimerValue();
+  // First frame, or more than a frame late: start over from now instead of rushing to catch up
+  if (deadline == 0 || now > deadline + period) deadline = now;
+  uint64_t spinTicks = static_cast<uint64_t>(SPIN_TIME * timerFrequency);
+  if (now + spinTicks < deadline) {
+    double sleepTime = static_cast<double>(deadline - now - spinTicks) / timerFrequency;
+    std::this_thread::sleep_for(std::chrono::duration<double>(sleepTime));
+  }
+  while (glfwGetTimerValue() < deadline) {
+  }
+  deadline += period;
+}
+
+double FramePacer::framePresented() {
+  uint64_t now = glfwGetTimerValue();
+  double interval = lastPresentTime == 0 ? 0.0 : 1000.0 * static_cast<double>(now - lastPresentTime) / timerFrequency;
+  lastPresentTime = now;
+  return interval;
+}
+
+void FramePacer::skipFrame() {
+  lastPresentTime = 0;
+  deadline = 0;
+}
@@ -0,0 +1,118 @@
+#include "frustum_culler.h"
+
+#include <array>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define FRUSTUM_CULLER_AVX
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define FRUSTUM_CULLER_SSE
+#endif
+
+namespace {
+constexpr std::size_t PADDING = 8;
+
+#if HAS_CXX20_SUPPORT
+inline int lowestBit(uint32_t mask) { return std::countr_zero(mask); }
+#else
+inline int lowestBit(uint32_t mask) {
+  int index = 0;
+  while ((mask & 1u) == 0) {
+    mask >>= 1;
+    ++index;
+  }
+  return index;
+}
+#endif
+
+/// @brief Append base + i for every set bit i of mask that is still inside the fleet
+inline void appendVisible(std::vector<uint32_t>& visible, uint32_t mask, std::size_t base, std::size_t count) {
+  while (mask != 0) {
+    std::size_t index = base + lowestBit(mask);
+    if (index < count) visible.push_back(static_cast<uint32_t>(index));
+    mask &= mask - 1;
+  }
+}
+}  // namespace
+
+FrustumCuller::FrustumCuller(const std::vector<AirplaneInstance>& fleet, const BoundingSphere& bounds)
+    : count(fleet.size()), origin(0.0), radius(bounds.radius), localCenter(bounds.center) {
+  std::size_t padded = (count + PADDING - 1) / PADDING * PADDING;
+  centerX.assign(padded, 0.0f);
+  centerY.assign(padded, 0.0f);
+  centerZ.assign(padded, 0.0f);
+  if (count > 0) {
+    glm::dvec3 lower = fleet[0].position;
+    glm::dvec3 upper = fleet[0].position;
+    for (const AirplaneInstance& instance : fleet) {
+      lower = glm::min(lower, instance.position);
+      upper = glm::max(upper, instance.position);
+    }
+    origin = (lower + upper) / 2.0;
+  }
+  for (std::size_t i = 0; i < count; ++i) {
+    glm::vec3 center = glm::vec3(fleet[i].position - origin) + localCenter;
+    centerX[i] = center.x;
+    centerY[i] = center.y;
+    centerZ[i] = center.z;
+  }
+  visible.reserve(count);
+}
+
+void FrustumCuller::cull(const Camera& camera, const FlightState& flight) {
+  if (camera.getVersion() == cameraVersion && flight.position == flightPosition && flight.heading == flightHeading) {
+    return;
+  }
+  cameraVersion = camera.getVersion();
+  flightPosition = flight.position;
+  flightHeading = flight.heading;
+  ++version;
+  visible.clear();
+  // Planes are relative to the camera. The flight moves origin and turns the center around each airplane origin
+  glm::vec3 offset = camera.toCameraRelative(origin + flight.position) +
+                     glm::vec3(flight.getRotation() * glm::vec4(localCenter, 1.0f)) - localCenter;
+  // Moving every sphere by offset is the same as moving the planes by -offset
+  std::array<glm::vec4, 6> planes = camera.getFrustumPlanes();
+  for (glm::vec4& plane : planes) plane.w += glm::dot(glm::vec3(plane), offset);
+  // A sphere is visible unless it lies completely behind one plane: dot(n, c) + d >= -r for all planes
+#if defined(FRUSTUM_CULLER_AVX)
+  for (std::size_t i = 0; i < count; i += 8) {
+    __m256 x = _mm256_loadu_ps(&centerX[i]);
+    __m256 y = _mm256_loadu_ps(&centerY[i]);
+    __m256 z = _mm256_loadu_ps(&centerZ[i]);
+    __m256 negativeRadius = _mm256_set1_ps(-radius);
+    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (const glm::vec4& plane : planes) {
+      __m256 distance = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(plane.x)), _mm256_set1_ps(plane.w));
+      distance = _mm256_add_ps(distance, _mm256_mul_ps(y, _mm256_set1_ps(plane.y)));
+      distance = _mm256_add_ps(distance, _mm256_mul_ps(z, _mm256_set1_ps(plane.z)));
+      inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+    }
+    appendVisible(visible, static_cast<uint32_t>(_mm256_movemask_ps(inside)), i, count);
+  }
+#elif defined(FRUSTUM_CULLER_SSE)
+  for (std::size_t i = 0; i < count; i += 4) {
+    __m128 x = _mm_loadu_ps(&centerX[i]);
+    __m128 y = _mm_loadu_ps(&centerY[i]);
+    __m128 z = _mm_loadu_ps(&centerZ[i]);
+    __m128 negativeRadius = _mm_set1_ps(-radius);
+    __m128 inside = _mm_cmpeq_ps(x, x);
+    for (const glm::vec4& plane : planes) {
+      __m128 distance = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_set1_ps(plane.w));
+      distance = _mm_add_ps(distance, _mm_mul_ps(y, _mm_set1_ps(plane.y)));
+      distance = _mm_add_ps(distance, _mm_mul_ps(z, _mm_set1_ps(plane.z)));
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+    }
+    appendVisible(visible, static_cast<uint32_t>(_mm_movemask_ps(inside)), i, count);
+  }
+#else
+  for (std::size_t i = 0; i < count; ++i) {
+    bool inside = true;
+    for (const glm::vec4& plane : planes) {
+      inside = inside && plane.x * centerX[i] + plane.y * centerY[i] + plane.z * centerZ[i] + plane.w >= -radius;
+    }
+    if (inside) visible.push_back(static_cast<uint32_t>(i));
+  }
+#endif
+}
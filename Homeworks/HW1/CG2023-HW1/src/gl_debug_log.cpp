@@ -0,0 +1,123 @@
+#include "gl_debug_log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+std::array<GLDebugLog::Slot, GLDebugLog::CAPACITY> GLDebugLog::slots;
+std::atomic<std::size_t> GLDebugLog::enqueuePosition{0};
+std::size_t GLDebugLog::dequeuePosition = 0;
+std::atomic<uint64_t> GLDebugLog::droppedCount{0};
+std::atomic<bool> GLDebugLog::running{false};
+std::thread GLDebugLog::thread;
+
+namespace {
+/// @brief Rate limit of one id
+struct RepeatWindow {
+  std::chrono::steady_clock::time_point start;
+  uint32_t shown = 0;
+  uint64_t suppressed = 0;
+};
+// Window of each id seen so far, only touched by the writer thread
+std::unordered_map<GLuint, RepeatWindow> repeatWindows;
+}  // namespace
+
+void GLDebugLog::start(Writer writer) {
+  if (running.exchange(true)) return;
+  for (std::size_t i = 0; i < CAPACITY; ++i) slots[i].sequence.store(i, std::memory_order_relaxed);
+  enqueuePosition.store(0, std::memory_order_relaxed);
+  dequeuePosition = 0;
+  thread = std::thread(run, writer);
+}
+
+void GLDebugLog::stop() {
+  if (!running.exchange(false)) return;
+  thread.join();
+  reportSuppressed(std::chrono::steady_clock::now(), true);
+  uint64_t dropped = droppedCount.exchange(0);
+  if (dropped > 0) std::cerr << dropped << " debug messages dropped, the queue was full\n";
+  std::cerr.flush();
+  repeatWindows.clear();
+}
+
+void GLDebugLog::push(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+                      const GLchar* message) {
+  std::size_t position = enqueuePosition.load(std::memory_order_relaxed);
+  Slot* slot = nullptr;
+  while (true) {
+    slot = &slots[position % CAPACITY];
+    std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    if (sequence == position) {
+      // Free slot, claim it
+      if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+    } else if (sequence < position) {
+      // Still holds a message from the previous lap
+      droppedCount.fetch_add(1, std::memory_order_relaxed);
+      return;
+    } else {
+      // Another producer claimed it first
+      position = enqueuePosition.load(std::memory_order_relaxed);
+    }
+  }
+  GLDebugMessage& copy = slot->message;
+  copy.source = source;
+  copy.type = type;
+  copy.id = id;
+  copy.severity = severity;
+  // Length may be negative if the driver does not provide it
+  std::size_t size = length >= 0 ? static_cast<std::size_t>(length) : std::strlen(message);
+  size = std::min(size, GLDebugMessage::MAX_LENGTH - 1);
+  std::memcpy(copy.text.data(), message, size);
+  copy.text[size] = '\0';
+  slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+bool GLDebugLog::pop(GLDebugMessage& message) {
+  Slot& slot = slots[dequeuePosition % CAPACITY];
+  if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1) return false;
+  message = slot.message;
+  slot.sequence.store(dequeuePosition + CAPACITY, std::memory_order_release);
+  ++dequeuePosition;
+  return true;
+}
+
+bool GLDebugLog::reportSuppressed(std::chrono::steady_clock::time_point now, bool flush) {
+  bool wrote = false;
+  for (auto& [id, window] : repeatWindows) {
+    if (window.suppressed == 0 || (!flush && now - window.start < REPEAT_WINDOW)) continue;
+    std::cerr << "Id: " << id << " repeated " << window.suppressed << " more times\n";
+    window.suppressed = 0;
+    wrote = true;
+  }
+  return wrote;
+}
+
+void GLDebugLog::run(Writer writer) {
+  GLDebugMessage message;
+  // Keep draining after stop() until the queue is empty
+  while (true) {
+    bool stopping = !running.load(std::memory_order_acquire);
+    auto now = std::chrono::steady_clock::now();
+    // Counts of windows that ended come before the messages that open the next ones
+    bool wrote = reportSuppressed(now, false);
+    while (pop(message)) {
+      RepeatWindow& window = repeatWindows[message.id];
+      if (now - window.start >= REPEAT_WINDOW) {
+        window.start = now;
+        window.shown = 0;
+      }
+      if (window.shown < REPEAT_LIMIT) {
+        ++window.shown;
+        writer(message);
+        wrote = true;
+      } else {
+        ++window.suppressed;
+      }
+    }
+    if (wrote) std::cerr.flush();
+    if (stopping) return;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+}
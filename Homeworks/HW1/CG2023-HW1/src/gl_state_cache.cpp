@@ -0,0 +1,178 @@
+#include "gl_state_cache.h"
+
+#include <algorithm>
+
+std::unordered_map<GLenum, bool> GLStateCache::capabilities;
+GLenum GLStateCache::depthFuncValue = GL_LESS;
+bool GLStateCache::depthFuncValid = false;
+std::array<GLfloat, 4> GLStateCache::clearColorValue = {0, 0, 0, 0};
+bool GLStateCache::clearColorValid = false;
+GLdouble GLStateCache::clearDepthValue = 1.0;
+bool GLStateCache::clearDepthValid = false;
+GLenum GLStateCache::shadeModelValue = GL_SMOOTH;
+bool GLStateCache::shadeModelValid = false;
+std::array<GLenum, 2> GLStateCache::colorMaterialValue = {GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE};
+bool GLStateCache::colorMaterialValid = false;
+std::unordered_map<uint32_t, std::array<GLfloat, 4>> GLStateCache::lightParameters;
+GLuint GLStateCache::program = 0;
+bool GLStateCache::programValid = false;
+GLuint GLStateCache::vertexArray = 0;
+bool GLStateCache::vertexArrayValid = false;
+std::unordered_map<uint32_t, GLuint> GLStateCache::buffers;
+std::unordered_map<uint32_t, std::array<GLintptr, 3>> GLStateCache::bufferRanges;
+uint32_t GLStateCache::issuedCount = 0;
+uint32_t GLStateCache::filteredCount = 0;
+uint32_t GLStateCache::lastIssuedCount = 0;
+uint32_t GLStateCache::lastFilteredCount = 0;
+
+namespace {
+/// @return Number of values glLightfv reads for pname
+int lightParameterSize(GLenum pname) {
+  switch (pname) {
+    case GL_SPOT_EXPONENT:
+    case GL_SPOT_CUTOFF:
+    case GL_CONSTANT_ATTENUATION:
+    case GL_LINEAR_ATTENUATION:
+    case GL_QUADRATIC_ATTENUATION:
+      return 1;
+    case GL_SPOT_DIRECTION:
+      return 3;
+    default:
+      return 4;
+  }
+}
+}  // namespace
+
+void GLStateCache::setCapability(GLenum capability, bool enabled) {
+  auto [it, inserted] = capabilities.try_emplace(capability, enabled);
+  if (update(inserted || it->second != enabled)) {
+    it->second = enabled;
+    if (enabled)
+      glEnable(capability);
+    else
+      glDisable(capability);
+  }
+}
+
+void GLStateCache::depthFunc(GLenum func) {
+  if (update(!depthFuncValid || depthFuncValue != func)) {
+    depthFuncValue = func;
+    depthFuncValid = true;
+    glDepthFunc(func);
+  }
+}
+
+void GLStateCache::clearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+  std::array<GLfloat, 4> color = {red, green, blue, alpha};
+  if (update(!clearColorValid || clearColorValue != color)) {
+    clearColorValue = color;
+    clearColorValid = true;
+    glClearColor(red, green, blue, alpha);
+  }
+}
+
+void GLStateCache::clearDepth(GLdouble depth) {
+  if (update(!clearDepthValid || clearDepthValue != depth)) {
+    clearDepthValue = depth;
+    clearDepthValid = true;
+    glClearDepth(depth);
+  }
+}
+
+void GLStateCache::shadeModel(GLenum mode) {
+  if (update(!shadeModelValid || shadeModelValue != mode)) {
+    shadeModelValue = mode;
+    shadeModelValid = true;
+    glShadeModel(mode);
+  }
+}
+
+void GLStateCache::colorMaterial(GLenum face, GLenum mode) {
+  std::array<GLenum, 2> value = {face, mode};
+  if (update(!colorMaterialValid || colorMaterialValue != value)) {
+    colorMaterialValue = value;
+    colorMaterialValid = true;
+    glColorMaterial(face, mode);
+  }
+}
+
+void GLStateCache::lightfv(GLenum light, GLenum pname, const GLfloat* params) {
+  // Positions are transformed by the current modelview matrix, equal arguments can still change the state
+  if (pname == GL_POSITION || pname == GL_SPOT_DIRECTION) {
+    update(true);
+    glLightfv(light, pname, params);
+    return;
+  }
+  std::array<GLfloat, 4> value = {0, 0, 0, 0};
+  std::copy_n(params, lightParameterSize(pname), value.begin());
+  auto [it, inserted] = lightParameters.try_emplace(static_cast<uint32_t>(light) << 16 | pname, value);
+  if (update(inserted || it->second != value)) {
+    it->second = value;
+    glLightfv(light, pname, params);
+  }
+}
+
+void GLStateCache::useProgram(GLuint _program) {
+  if (update(!programValid || program != _program)) {
+    program = _program;
+    programValid = true;
+    glUseProgram(_program);
+  }
+}
+
+void GLStateCache::bindVertexArray(GLuint _vertexArray) {
+  if (update(!vertexArrayValid || vertexArray != _vertexArray)) {
+    vertexArray = _vertexArray;
+    vertexArrayValid = true;
+    glBindVertexArray(_vertexArray);
+    // The element array binding is part of the vertex array
+    buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+  }
+}
+
+void GLStateCache::bindBuffer(GLenum target, GLuint buffer) {
+  auto [it, inserted] = buffers.try_emplace(target, buffer);
+  if (update(inserted || it->second != buffer)) {
+    it->second = buffer;
+    glBindBuffer(target, buffer);
+  }
+}
+
+void GLStateCache::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+  auto [it, inserted] = buffers.try_emplace(static_cast<uint32_t>(target) << 8 | index, buffer);
+  if (update(inserted || it->second != buffer)) {
+    it->second = buffer;
+    glBindBufferBase(target, index, buffer);
+    // Binding an indexed target also binds the generic one
+    buffers[target] = buffer;
+    bufferRanges.erase(it->first);
+  }
+}
+
+void GLStateCache::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+  uint32_t key = static_cast<uint32_t>(target) << 8 | index;
+  std::array<GLintptr, 3> range = {static_cast<GLintptr>(buffer), offset, size};
+  auto [it, inserted] = bufferRanges.try_emplace(key, range);
+  if (update(inserted || it->second != range)) {
+    it->second = range;
+    glBindBufferRange(target, index, buffer, offset, size);
+    buffers[target] = buffer;
+    // Not a whole buffer binding, the next bindBufferBase must reach OpenGL
+    buffers.erase(key);
+  }
+}
+
+void GLStateCache::invalidate() {
+  capabilities.clear();
+  depthFuncValid = clearColorValid = clearDepthValid = shadeModelValid = colorMaterialValid = false;
+  lightParameters.clear();
+  programValid = vertexArrayValid = false;
+  buffers.clear();
+  bufferRanges.clear();
+}
+
+void GLStateCache::beginFrame() {
+  lastIssuedCount = issuedCount;
+  lastFilteredCount = filteredCount;
+  issuedCount = filteredCount = 0;
+}
@@ -0,0 +1,79 @@
+#include "gpu_timer.h"
+
+const char* toString(GpuPass pass) {
+  switch (pass) {
+    case GpuPass::Clear:
+      return "clear";
+    case GpuPass::Board:
+      return "board";
+    case GpuPass::Airplanes:
+      return "airplanes";
+  }
+  return "unknown";
+}
+
+GpuTimer::GpuTimer() : supported(isSupported()) {
+  if (!supported) return;
+  for (Pool& pool : pools) glGenQueries(static_cast<GLsizei>(pool.queries.size()), pool.queries.data());
+}
+
+GpuTimer::~GpuTimer() {
+  if (!supported) return;
+  for (Pool& pool : pools) glDeleteQueries(static_cast<GLsizei>(pool.queries.size()), pool.queries.data());
+}
+
+bool GpuTimer::isSupported() { return GLAD_GL_VERSION_3_3 || GLAD_GL_ARB_timer_query; }
+
+void GpuTimer::beginFrame() {
+  if (!supported) return;
+  if (pending == FRAME_LATENCY) readOldest();
+  Pool& pool = pools[head];
+  pool.marked.fill(false);
+  pool.last = pool.queries[0];
+  glQueryCounter(pool.queries[0], GL_TIMESTAMP);
+}
+
+void GpuTimer::endPass(GpuPass pass) {
+  if (!supported) return;
+  Pool& pool = pools[head];
+  int index = static_cast<int>(pass);
+  pool.marked[index] = true;
+  pool.last = pool.queries[index + 1];
+  glQueryCounter(pool.last, GL_TIMESTAMP);
+}
+
+void GpuTimer::endFrame() {
+  if (!supported) return;
+  head = (head + 1) % FRAME_LATENCY;
+  ++pending;
+  // Timestamps complete in order, the last one of a frame tells if the whole pool is ready
+  while (pending > 0) {
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(pools[(head - pending + FRAME_LATENCY) % FRAME_LATENCY].last, GL_QUERY_RESULT_AVAILABLE,
+                        &available);
+    if (available != GL_TRUE) break;
+    readOldest();
+  }
+}
+
+void GpuTimer::finish() {
+  while (pending > 0) readOldest();
+}
+
+void GpuTimer::readOldest() {
+  const Pool& pool = pools[(head - pending + FRAME_LATENCY) % FRAME_LATENCY];
+  --pending;
+  GLuint64 start = 0, previous = 0;
+  glGetQueryObjectui64v(pool.queries[0], GL_QUERY_RESULT, &start);
+  previous = start;
+  FrameTimes frame;
+  for (int i = 0; i < GPU_PASS_COUNT; ++i) {
+    if (!pool.marked[i]) continue;
+    GLuint64 end = 0;
+    glGetQueryObjectui64v(pool.queries[i + 1], GL_QUERY_RESULT, &end);
+    frame.passes[i] = static_cast<double>(end - previous) * 1e-6;
+    previous = end;
+  }
+  frame.total = static_cast<double>(previous - start) * 1e-6;
+  results.push_back(frame);
+}
@@ -0,0 +1,22 @@
+#include "input_queue.h"
+
+bool InputQueue::push(const InputEvent& event) {
+  std::size_t position = writePosition.load(std::memory_order_relaxed);
+  if (position - readPosition.load(std::memory_order_acquire) == CAPACITY) {
+    droppedCount.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  events[position % CAPACITY] = event;
+  writePosition.store(position + 1, std::memory_order_release);
+  return true;
+}
+
+bool InputQueue::popUntil(double time, InputEvent& event) {
+  std::size_t position = readPosition.load(std::memory_order_relaxed);
+  if (position == writePosition.load(std::memory_order_acquire)) return false;
+  const InputEvent& oldest = events[position % CAPACITY];
+  if (oldest.time > time) return false;
+  event = oldest;
+  readPosition.store(position + 1, std::memory_order_release);
+  return true;
+}
@@ -0,0 +1,129 @@
+#include "input_recorder.h"
+
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+constexpr char MAGIC[4] = {'H', 'W', '1', 'I'};
+constexpr uint8_t VERSION = 1;
+
+template <typename T>
+void append(std::vector<char>& bytes, T value) {
+  const char* begin = reinterpret_cast<const char*>(&value);
+  bytes.insert(bytes.end(), begin, begin + sizeof(T));
+}
+
+/// @brief Sequential reader over the bytes of a recording
+class Reader {
+ public:
+  explicit Reader(const std::vector<char>& _bytes) : bytes(_bytes) {}
+  bool atEnd() const { return offset == bytes.size(); }
+  template <typename T>
+  T read() {
+    if (bytes.size() - offset < sizeof(T)) THROW_EXCEPTION(std::runtime_error, "Truncated input recording");
+    T value;
+    std::memcpy(&value, bytes.data() + offset, sizeof(T));
+    offset += sizeof(T);
+    return value;
+  }
+
+ private:
+  const std::vector<char>& bytes;
+  std::size_t offset = 0;
+};
+}  // namespace
+
+InputRecorder::InputRecorder(const std::string& path, double _startTime)
+    : file(path, std::ios::binary), startTime(_startTime) {
+  if (!file) THROW_EXCEPTION(std::runtime_error, "Cannot open " + path);
+  file.write(MAGIC, sizeof(MAGIC));
+  file.put(static_cast<char>(VERSION));
+}
+
+void InputRecorder::key(double time, int key, int action) {
+  RecordedInput input;
+  input.type = RecordedInput::Type::Key;
+  input.time = time - startTime;
+  input.key = key;
+  input.action = action;
+  write(input);
+}
+
+void InputRecorder::cursorPos(double time, double x, double y) {
+  RecordedInput input;
+  input.type = RecordedInput::Type::CursorPos;
+  input.time = time - startTime;
+  input.cursor = glm::dvec2(x, y);
+  write(input);
+}
+
+void InputRecorder::resize(double time, int width, int height) {
+  RecordedInput input;
+  input.type = RecordedInput::Type::Resize;
+  input.time = time - startTime;
+  input.width = width;
+  input.height = height;
+  write(input);
+}
+
+void InputRecorder::write(const RecordedInput& input) {
+  std::vector<char> bytes;
+  append(bytes, static_cast<uint8_t>(input.type));
+  append(bytes, input.time);
+  switch (input.type) {
+    case RecordedInput::Type::Key:
+      append(bytes, static_cast<int16_t>(input.key));
+      append(bytes, static_cast<uint8_t>(input.action));
+      break;
+    case RecordedInput::Type::CursorPos:
+      append(bytes, input.cursor.x);
+      append(bytes, input.cursor.y);
+      break;
+    case RecordedInput::Type::Resize:
+      append(bytes, static_cast<int32_t>(input.width));
+      append(bytes, static_cast<int32_t>(input.height));
+      break;
+  }
+  file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  ++count;
+}
+
+InputReplayer::InputReplayer(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) THROW_EXCEPTION(std::runtime_error, "Cannot open " + path);
+  std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  Reader reader(bytes);
+  for (char magic : MAGIC) {
+    if (reader.read<char>() != magic) THROW_EXCEPTION(std::runtime_error, path + " is not an input recording");
+  }
+  if (reader.read<uint8_t>() != VERSION) THROW_EXCEPTION(std::runtime_error, "Unsupported version of " + path);
+  while (!reader.atEnd()) {
+    RecordedInput input;
+    input.type = static_cast<RecordedInput::Type>(reader.read<uint8_t>());
+    input.time = reader.read<double>();
+    switch (input.type) {
+      case RecordedInput::Type::Key:
+        input.key = reader.read<int16_t>();
+        input.action = reader.read<uint8_t>();
+        break;
+      case RecordedInput::Type::CursorPos:
+        input.cursor.x = reader.read<double>();
+        input.cursor.y = reader.read<double>();
+        break;
+      case RecordedInput::Type::Resize:
+        input.width = reader.read<int32_t>();
+        input.height = reader.read<int32_t>();
+        break;
+      default:
+        THROW_EXCEPTION(std::runtime_error, "Unknown input type in " + path);
+    }
+    inputs.push_back(input);
+  }
+}
+
+bool InputReplayer::next(double time, RecordedInput& input) {
+  if (isFinished() || inputs[position].time > time) return false;
+  input = inputs[position++];
+  return true;
+}
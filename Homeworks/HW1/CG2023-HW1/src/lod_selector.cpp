@@ -0,0 +1,47 @@
+#include "lod_selector.h"
+
+#include <cmath>
+#include <limits>
+
+float LodSelector::bias = 0.0f;
+
+LodSelector::LodSelector(std::size_t fleetSize, const BoundingSphere& bounds)
+    : localCenter(bounds.center), radius(bounds.radius), levels(fleetSize, -1) {
+  for (int level = 0; level < LOD_LEVEL_COUNT; ++level) {
+    // A side of n segments is 1 - cos(pi / n) of the fuselage radius away from the circle at its middle
+    double error = 1.0 - std::cos(utils::PI<double>() / LOD_SEGMENTS[level]);
+    maxPixels[level] = static_cast<float>(MAX_ERROR_PIXELS / error * radius / BODY_RADIUS);
+  }
+  // Nothing is finer than the last level
+  maxPixels.back() = std::numeric_limits<float>::infinity();
+}
+
+void LodSelector::update(const Camera& camera, int viewportHeight, const std::vector<AirplaneInstance>& fleet,
+                         const FrustumCuller& culler, const FlightState& flight) {
+  if (culler.getVersion() == cullerVersion && viewportHeight == lastViewportHeight && bias == lastBias) return;
+  PROFILE_SCOPE("LodSelector::update");
+  cullerVersion = culler.getVersion();
+  lastViewportHeight = viewportHeight;
+  lastBias = bias;
+  ++version;
+  // Projected radius is radius * pixelScale / distance, the focal length is element [1][1] of the projection
+  float pixelScale = camera.getProjectionMatrix()[5] * viewportHeight / 2.0f * std::exp2(bias);
+  // The flight turns every center around its airplane origin by the same amount
+  glm::vec3 center(flight.getRotation() * glm::vec4(localCenter, 1.0f));
+  levelCounts.fill(0);
+  for (uint32_t index : culler.getVisible()) {
+    // Airplane origin relative to the camera in double precision, only the small difference is narrowed
+    float distance = glm::length(camera.toCameraRelative(fleet[index].position + flight.position) + center);
+    float pixels = distance > radius ? radius * pixelScale / distance : std::numeric_limits<float>::infinity();
+    int target = 0;
+    while (pixels > maxPixels[target]) ++target;
+    int level = levels[index];
+    if (level < target) {
+      level = target;
+    } else {
+      while (level > target && pixels <= maxPixels[level - 1] * (1.0f - HYSTERESIS)) --level;
+    }
+    levels[index] = static_cast<int8_t>(level);
+    ++levelCounts[level];
+  }
+}
@@ -1,5 +1,14 @@
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <iostream>
 
@@ -8,40 +17,113 @@
 #include <glad/gl.h>
 #undef GLAD_GL_IMPLEMENTATION
 #include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
 
+#include "airplane.h"
+#include "bench_report.h"
 #include "camera.h"
+#include "cylinder_mesh.h"
+#include "draw_stats.h"
+#include "frame_pacer.h"
+#include "frustum_culler.h"
+#include "gl_state_cache.h"
+#include "gpu_timer.h"
+#include "input_recorder.h"
+#include "lod_selector.h"
+#include "matrix_stack.h"
+#include "mesh_cache.h"
 #include "opengl_context.h"
+#include "options.h"
+#include "renderer.h"
+#include "simulation.h"
+#include "split_screen.h"
 #include "utils.h"
 
 #define ANGLE_TO_RADIAN(x) (float)((x)*M_PI / 180.0f) 
 #define RADIAN_TO_ANGEL(x) (float)((x)*180.0f / M_PI) 
 
-#define CIRCLE_SEGMENT 64
+// Benchmark runs: frames when --frames is not given, and frames rendered first but left out of the report
+#define BENCH_FRAME_COUNT 1000
+#define BENCH_WARMUP_FRAMES 10
+// Chrome trace written on exit and on F12 in builds with ENABLE_PROFILER
+#define PROFILE_TRACE_PATH "trace.json"
+// Longest wait for input with --idle, in seconds, so the idle statistics still get printed
+#define IDLE_WAIT_TIMEOUT 0.25
+
+// Callbacks run on the main thread as events arrive, frames render on their own thread. inputMutex guards keysDown,
+// the pending resize and inputCount, inputArrived wakes a render thread waiting for input with --idle
+static std::mutex inputMutex;
+static std::condition_variable inputArrived;
+static uint64_t inputCount = 0;
+// Keys held, from key events so replays can drive them too
+static KeyState keysDown = {};
+// Framebuffer size of the last resize, applied by the render thread at the start of its next frame
+static bool resizePending = false;
+static glm::ivec2 pendingSize(0);
+// Set when the window contents were lost or resized, --idle redraws even if the scene did not change
+static std::atomic<bool> redrawRequested{true};
+// Set by ESC, the close button, the end of a replay or the last frame, the render loop stops before its next frame
+static std::atomic<bool> closeRequested{false};
+// --record writes every input callback, --replay feeds a recording back instead of the devices
+static std::unique_ptr<InputRecorder> inputRecorder;
+static std::unique_ptr<InputReplayer> inputReplayer;
+
+
+/// @brief Wake the render thread if it waits for input, call after changing anything it reads
+void notifyInput() {
+  {
+    std::lock_guard<std::mutex> lock(inputMutex);
+    ++inputCount;
+  }
+  inputArrived.notify_one();
+}
 
-#define ROTATE_SPEED 1.0f
-#define FLYING_SPEED ROTATE_SPEED / 20.f
+void requestClose() {
+  closeRequested.store(true, std::memory_order_relaxed);
+  notifyInput();
+}
 
-#define RED 0.905f, 0.298f, 0.235f
-#define BLUE 0.203f, 0.596f, 0.858f
-#define GREEN 0.18f, 0.8f, 0.443f
+void refreshCallback(GLFWwindow*) {
+  redrawRequested.store(true, std::memory_order_relaxed);
+  notifyInput();
+}
 
+void resizeCallback(GLFWwindow*, int width, int height) {
+  if (inputRecorder) inputRecorder->resize(glfwGetTime(), width, height);
+  // The viewport and the cameras belong to the render thread
+  {
+    std::lock_guard<std::mutex> lock(inputMutex);
+    resizePending = true;
+    pendingSize = glm::ivec2(width, height);
+  }
+  refreshCallback(nullptr);
+}
 
-void resizeCallback(GLFWwindow* window, int width, int height) {
-  OpenGLContext::framebufferResizeCallback(window, width, height);
-  auto ptr = static_cast<Camera*>(glfwGetWindowUserPointer(window));
+void cursorPosCallback(GLFWwindow* window, double x, double y) {
+  // GLFW gives no event time, but the main thread waits in glfwWaitEvents, so this runs as the event arrives
+  double time = glfwGetTime();
+  if (inputRecorder) inputRecorder->cursorPos(time, x, y);
+  if (inputReplayer) return;
+  auto ptr = static_cast<SplitScreen*>(glfwGetWindowUserPointer(window));
   if (ptr) {
-    ptr->updateProjectionMatrix(OpenGLContext::getAspectRatio());
+    ptr->getMainCamera().onCursorPos(x, y, time);
+    notifyInput();
   }
 }
 
-void keyCallback(GLFWwindow* window, int key, int, int action, int) {
+void handleKey(int key, int action) {
   // There are three actions: press, release, hold(repeat)
   if (action == GLFW_REPEAT) 
       return;
 
   // Press ESC to close the window.
   if (key == GLFW_KEY_ESCAPE) {
-    glfwSetWindowShouldClose(window, GLFW_TRUE);
+    requestClose();
+    return;
+  }
+  // Press F12 to write the profiler trace so far
+  if (key == GLFW_KEY_F12 && action == GLFW_PRESS) {
+    if (PROFILE_DUMP(PROFILE_TRACE_PATH)) std::cout << "Profile written to " PROFILE_TRACE_PATH << std::endl;
     return;
   }
   /* TODO#4-1: Detect key-events, perform rotation or fly
@@ -56,16 +138,55 @@ void keyCallback(GLFWwindow* window, int key, int, int action, int) {
    *       You should finish rendering your airplane first.
    *       Otherwise you will spend a lot of time debugging this with a black screen.
    */
+  // Simulation steps read the held keys, see sampleInput()
+  if (key < 0 || key > GLFW_KEY_LAST) return;
+  {
+    std::lock_guard<std::mutex> lock(inputMutex);
+    keysDown[key] = action == GLFW_PRESS;
+  }
+  notifyInput();
 }
 
-void initOpenGL() {
+void keyCallback(GLFWwindow*, int key, int, int action, int) {
+  if (inputRecorder) inputRecorder->key(glfwGetTime(), key, action);
+  // Replays only follow the recording, ESC still closes the window
+  if (inputReplayer && key != GLFW_KEY_ESCAPE) return;
+  handleKey(key, action);
+}
+
+/// @brief Apply an input of --replay like its callback would have
+void replayInput(SplitScreen& splitScreen, const RecordedInput& input) {
+  switch (input.type) {
+    case RecordedInput::Type::Key:
+      handleKey(input.key, input.action);
+      break;
+    case RecordedInput::Type::CursorPos:
+      splitScreen.getMainCamera().onCursorPos(input.cursor.x, input.cursor.y, input.time);
+      break;
+    case RecordedInput::Type::Resize:
+      // The window keeps its own size, only the cameras see the recorded one
+      splitScreen.updateProjections(input.width, input.height);
+      break;
+  }
+}
+
+void initOpenGL(RenderPath renderPath, bool headless) {
   // Initialize OpenGL context, details are wrapped in class.
+  // Only the immediate path needs the fixed function pipeline, the others run on a core profile.
 #ifdef __APPLE__
-  // MacOS need explicit request legacy support
-  OpenGLContext::createContext(21, GLFW_OPENGL_ANY_PROFILE);
+  if (renderPath == RenderPath::Immediate) {
+    // MacOS need explicit request legacy support
+    OpenGLContext::createContext(21, GLFW_OPENGL_ANY_PROFILE, headless);
+  } else {
+    // MacOS core profile stops at 4.1
+    OpenGLContext::createContext(41, GLFW_OPENGL_CORE_PROFILE, headless);
+  }
 #else
-  //OpenGLContext::createContext(21, GLFW_OPENGL_ANY_PROFILE);
-  OpenGLContext::createContext(43, GLFW_OPENGL_COMPAT_PROFILE);
+  if (renderPath == RenderPath::Immediate) {
+    OpenGLContext::createContext(43, GLFW_OPENGL_COMPAT_PROFILE, headless);
+  } else {
+    OpenGLContext::createContext(43, GLFW_OPENGL_CORE_PROFILE, headless);
+  }
 #endif
   GLFWwindow* window = OpenGLContext::getWindow();
   /* TODO#0: Change window title to "HW1 - `your student id`"
@@ -74,7 +195,11 @@ void initOpenGL() {
   glfwSetWindowTitle(window, "HW1 - 312553024");
   glfwSetKeyCallback(window, keyCallback);
   glfwSetFramebufferSizeCallback(window, resizeCallback);
+  glfwSetWindowRefreshCallback(window, refreshCallback);
+  glfwSetCursorPosCallback(window, cursorPosCallback);
   glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+  // Unaccelerated motion straight from the device, only available with a disabled cursor
+  if (glfwRawMouseMotionSupported()) glfwSetInputMode(window, GLFW_RAW_MOUSE_MOTION, GLFW_TRUE);
 #ifndef NDEBUG
   OpenGLContext::printSystemInfo();
   // This is useful if you want to debug your OpenGL API calls.
@@ -96,36 +221,36 @@ void initOpenGL() {
 
 void draw_cylinder(float radius, float height, int segments) {
   // Draw a cylinder with top and bottom faces and the specified parameters
-  float angleIncrement = 2.0f * M_PI / segments;
+  // Unit circle positions, baked at compile time for common segment counts
+  const UnitCircle circle(segments);
 
   // Draw the top face
   glBegin(GL_POLYGON);
   glNormal3f(0.0f, 1.0f, 0.0f);  // Define the normal for lighting
   for (int i = 0; i < segments; i++) {
-    float angle = static_cast<float>(i) * angleIncrement;
-    float x = radius * cos(angle);
-    float z = radius * sin(angle);
+    float x = radius * circle[i].x;
+    float z = radius * circle[i].z;
     glVertex3f(x, height / 2.0f, z);
   }
   glEnd();
+  DrawStats::record(segments);
 
   // Draw the bottom face
   glBegin(GL_POLYGON);
   glNormal3f(0.0f, -1.0f, 0.0f);  // Define the normal for lighting
   for (int i = 0; i < segments; i++) {
-    float angle = static_cast<float>(i) * angleIncrement;
-    float x = radius * cos(angle);
-    float z = radius * sin(angle);
+    float x = radius * circle[i].x;
+    float z = radius * circle[i].z;
     glVertex3f(x, -height / 2.0f, z);
   }
   glEnd();
+  DrawStats::record(segments);
 
   // Draw the side faces
   glBegin(GL_QUAD_STRIP);
   for (int i = 0; i <= segments; i++) {
-    float angle = static_cast<float>(i) * angleIncrement;
-    float x = radius * cos(angle);
-    float z = radius * sin(angle);
+    float x = radius * circle[i].x;
+    float z = radius * circle[i].z;
 
     glNormal3f(x, 0.0f, z);  // Define the normal for lighting
 
@@ -136,16 +261,19 @@ void draw_cylinder(float radius, float height, int segments) {
     glVertex3f(x, y2, z);  // Top
   }
   glEnd();
+  DrawStats::record(2 * (segments + 1));
 }
 
-void render_body() {
+void render_body(MatrixStack& stack, int segments = CIRCLE_SEGMENT) {
+  PROFILE_SCOPE("render_body");
   // Render the body (cylinder) with top and bottom faces
-  glPushMatrix();
-  glTranslatef(0.0f, 0.5f, 0.0f);             // Translate to the desired position
-  glRotatef(-90.0f, 1.0f, 0.0f, 0.0f);        // Rotate the body by 90 degrees around the X-axis
-  glColor3f(BLUE);                            // Set the color to red
-  draw_cylinder(0.5f, 4.0f, CIRCLE_SEGMENT);  // Render the body using draw cylinder
-  glPopMatrix();
+  stack.push();
+  stack.translate(0.0f, 0.5f, 0.0f);           // Translate to the desired position
+  stack.rotate(-90.0f, 1.0f, 0.0f, 0.0f);      // Rotate the body by 90 degrees around the X-axis
+  glLoadMatrixf(stack.data());                 // Upload the composed modelview once
+  glColor3f(BLUE);                             // Set the color to red
+  draw_cylinder(BODY_RADIUS, 4.0f, segments);  // Render the body using draw cylinder
+  stack.pop();
 }
 
 void draw_rectangle(float length, float width, float height) {
@@ -200,22 +328,30 @@ void draw_rectangle(float length, float width, float height) {
   glVertex3f(-halfLength, -halfHeight, -halfWidth);
 
   glEnd();
+  DrawStats::record(24);
 }
 
-void render_wings() {
-  // Render the wings of airplane
-  glPushMatrix();
-  glTranslatef(2.0f, 0.5f, 0.0f);             // Translate to the desired position
-  glColor3f(RED);                            // Set the color to red
-  draw_rectangle(4.0f, 1.0f, 0.5f);  // Render the body using drawCylinder
-  glPopMatrix();
+void render_wings(MatrixStack& stack, float angle) {
+  PROFILE_SCOPE("render_wings");
+  // Render the wings of airplane, raised by angle around the body axis
+  stack.push();
+  stack.translate(0.0f, 0.5f, 0.0f);      // Move to the body axis
+  stack.rotate(angle, 0.0f, 0.0f, 1.0f);  // Raise the wing
+  stack.translate(2.0f, 0.0f, 0.0f);      // Translate to the desired position
+  glLoadMatrixf(stack.data());            // Upload the composed modelview once
+  glColor3f(RED);                         // Set the color to red
+  draw_rectangle(4.0f, 1.0f, 0.5f);       // Render the body using drawCylinder
+  stack.pop();
 
   // Render the wings of airplane
-  glPushMatrix();
-  glTranslatef(-2.0f, 0.5f, 0.0f);  // Translate to the desired position
-  glColor3f(RED);                    // Set the color to red
-  draw_rectangle(4.0f, 1.0f, 0.5f);  // Render the body using drawCylinder
-  glPopMatrix();
+  stack.push();
+  stack.translate(0.0f, 0.5f, 0.0f);       // Move to the body axis
+  stack.rotate(-angle, 0.0f, 0.0f, 1.0f);  // Raise the wing
+  stack.translate(-2.0f, 0.0f, 0.0f);      // Translate to the desired position
+  glLoadMatrixf(stack.data());             // Upload the composed modelview once
+  glColor3f(RED);                          // Set the color to red
+  draw_rectangle(4.0f, 1.0f, 0.5f);        // Render the body using drawCylinder
+  stack.pop();
 }
 
 void draw_triangle(float bottomEdge, float height1, float height2) {
@@ -244,15 +380,19 @@ void draw_triangle(float bottomEdge, float height1, float height2) {
   glVertex3f(0.0f, -height2, height1);            // Bottom-left vertex
   glVertex3f(bottomEdge / 2.0f, 0.0f, height1);   // Bottom-right vertex
   glEnd();
+  DrawStats::record(12);
 }
 
-void render_tail() {
+void render_tail(MatrixStack& stack) {
+  PROFILE_SCOPE("render_tail");
   // Render the tail of the airplane
-  glPushMatrix();
+  stack.push();
   // Translate to the correct position relative to the body
-  glTranslatef(0.0f, 0.5f, 2.0f);
+  stack.translate(0.0f, 0.5f, 2.0f);
   // Rotate the tail if needed
-  // glRotatef(angle, 1.0f, 0.0f, 0.0f);  // Rotate the tail around the X-axis
+  // stack.rotate(angle, 1.0f, 0.0f, 0.0f);  // Rotate the tail around the X-axis
+  // Upload the composed modelview once
+  glLoadMatrixf(stack.data());
 
   // Set the color (e.g., GREEN or your desired color)
   glColor3f(GREEN);
@@ -260,9 +400,25 @@ void render_tail() {
   // Draw the tail as a tetrahedron (adjust dimensions as needed)
   draw_triangle(2.0f, 1.0f, 0.5f);
 
-  glPopMatrix();
+  stack.pop();
+}
+void render_board(MatrixStack& stack) {
+  PROFILE_SCOPE("render_board");
+  // Render a white board
+  stack.push();
+  stack.scale(3, 1, 3);
+  glLoadMatrixf(stack.data());
+  glBegin(GL_TRIANGLE_STRIP);
+  glColor3f(1.0f, 1.0f, 1.0f);
+  glNormal3f(0.0f, 1.0f, 0.0f);
+  glVertex3f(-5.0f, 0.0f, -5.0f);
+  glVertex3f(-5.0f, 0.0f, 5.0f);
+  glVertex3f(5.0f, 0.0f, -5.0f);
+  glVertex3f(5.0f, 0.0f, 5.0f);
+  glEnd();
+  DrawStats::record(4);
+  stack.pop();
 }
-
 
 void light() {
   GLfloat light_specular[] = {0.6, 0.6, 0.6, 1};
@@ -270,107 +426,464 @@ void light() {
   GLfloat light_ambient[] = {0.4, 0.4, 0.4, 1};
   GLfloat light_position[] = {50.0, 75.0, 80.0, 1.0};
   // z buffer enable
-  glEnable(GL_DEPTH_TEST);
+  GLStateCache::enable(GL_DEPTH_TEST);
   // enable lighting
-  glEnable(GL_LIGHTING);
-  glShadeModel(GL_SMOOTH);
-  glEnable(GL_COLOR_MATERIAL);
-  glColorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
-  glEnable(GL_NORMALIZE);
+  GLStateCache::enable(GL_LIGHTING);
+  GLStateCache::shadeModel(GL_SMOOTH);
+  GLStateCache::enable(GL_COLOR_MATERIAL);
+  GLStateCache::colorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
+  GLStateCache::enable(GL_NORMALIZE);
   // set light property
-  glEnable(GL_LIGHT0);
-  glLightfv(GL_LIGHT0, GL_POSITION, light_position);
-  glLightfv(GL_LIGHT0, GL_DIFFUSE, light_diffuse);
-  glLightfv(GL_LIGHT0, GL_SPECULAR, light_specular);
-  glLightfv(GL_LIGHT0, GL_AMBIENT, light_ambient);
+  GLStateCache::enable(GL_LIGHT0);
+  GLStateCache::lightfv(GL_LIGHT0, GL_POSITION, light_position);
+  GLStateCache::lightfv(GL_LIGHT0, GL_DIFFUSE, light_diffuse);
+  GLStateCache::lightfv(GL_LIGHT0, GL_SPECULAR, light_specular);
+  GLStateCache::lightfv(GL_LIGHT0, GL_AMBIENT, light_ambient);
 }
 
-int main() {
-  initOpenGL();
+/// @brief Draw the board and the visible airplanes seen from camera into the current viewport
+void render_scene(MatrixStack& modelView, const Camera& camera, const std::vector<AirplaneInstance>& fleet,
+                  const FrustumCuller& culler, const LodSelector& lod, const FlightState& flight, GpuTimer* gpuTimer) {
+  PROFILE_SCOPE("render_scene");
+  // Projection Matrix
+  glMatrixMode(GL_PROJECTION);
+  glLoadMatrixf(camera.getProjectionMatrix());
+  // ModelView Matrix, light() and the board sit at the world origin, every part loads its own composed matrix
+  glMatrixMode(GL_MODELVIEW);
+  glm::vec3 origin = camera.toCameraRelative(glm::dvec3(0.0));
+  modelView.load(glm::make_mat4(camera.getViewMatrix()));
+  modelView.push();
+  modelView.translate(origin.x, origin.y, origin.z);
+  glLoadMatrixf(modelView.data());
+  light();
+  render_board(modelView);
+  // Back to the view, airplanes are placed relative to the camera
+  modelView.pop();
+  if (gpuTimer) gpuTimer->endPass(GpuPass::Board);
+  glm::mat4 rotation = flight.getRotation();
+  for (uint32_t index : culler.getVisible()) {
+    // Subtract in double precision, the difference is small next to the camera
+    glm::vec3 offset = camera.toCameraRelative(fleet[index].position + flight.position);
+    modelView.push();
+    modelView.translate(offset.x, offset.y, offset.z);
+    modelView.multiply(rotation);
+    render_body(modelView, LOD_SEGMENTS[lod.getLevel(index)]);
+    render_wings(modelView, flight.wingAngle);
+    render_tail(modelView);
+    modelView.pop();
+  }
+  if (gpuTimer) gpuTimer->endPass(GpuPass::Airplanes);
+}
+
+int main(int argc, char** argv) {
+  Options options = parseOptions(argc, argv);
+#ifdef HW1_BENCHMARK
+  if (options.frameCount == 0) options.frameCount = BENCH_FRAME_COUNT;
+  const bool benchmark = true;
+#else
+  const bool benchmark = !options.jsonPath.empty();
+#endif
+  // A report without --json is all that goes to stdout, so it stays valid JSON when redirected, the rest goes to stderr
+  std::ostream reportOut(std::cout.rdbuf());
+  if (benchmark && options.jsonPath.empty()) std::cout.rdbuf(std::cerr.rdbuf());
+  initOpenGL(options.renderPath, options.headless);
   GLFWwindow* window = OpenGLContext::getWindow();
+  // Meshes of the core profile paths are built once here, identical primitives are shared
+  MeshCache meshCache;
+  std::vector<AirplaneInstance> fleet = makeFleet(options.instanceCount);
+  std::unique_ptr<Renderer> renderer;
+  if (options.renderPath == RenderPath::Retained) {
+    renderer = std::make_unique<RetainedRenderer>(meshCache, fleet);
+  } else if (options.renderPath == RenderPath::Instanced) {
+    renderer = std::make_unique<InstancedRenderer>(meshCache, fleet);
+  }
+  if (renderer) {
+    std::cout << "Mesh cache: " << meshCache.getHitCount() << " hits, " << meshCache.getMissCount() << " misses"
+              << std::endl;
+  }
 
   // Init Camera helper
   Camera camera(glm::vec3(0, 5, 10));
-  camera.initialize(OpenGLContext::getAspectRatio());
-  // Store camera as glfw global variable for callbasks use
-  glfwSetWindowUserPointer(window, &camera);
-
-  // Main rendering loop
-  while (!glfwWindowShouldClose(window)) {
-    // Polling events.
-    glfwPollEvents();
-    // Update camera position and view
-    camera.move(window);
-    // GL_XXX_BIT can simply "OR" together to use.
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    /// TO DO Enable DepthTest
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
-    // Projection Matrix
-    glMatrixMode(GL_PROJECTION);
-    glLoadMatrixf(camera.getProjectionMatrix());
-    // ModelView Matrix
-    glMatrixMode(GL_MODELVIEW);
-    glLoadMatrixf(camera.getViewMatrix());
-
-
-//#ifndef DISABLE_LIGHT   
-    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glClearDepth(1.0f);
-    light();
-//#endif
-
-    /* TODO#4-2: Update 
-     *       You may update position and orientation of airplane here or not.
-     *       Feel free to not follow TA's structure. However, don't violate the spec. 
-     * 
-     * Hint: 
-     * Note:
-     *       You can use `ROTATE_SPEED` and `FLYING_SPEED` as the speed constant. 
-     *       If the rotate/flying speed is too slow or too fast, please change `ROTATE_SPEED` or `FLYING_SPEED` value.
-     *       You should finish keyCallback first.
-     */
-
-    // Render a white board
-    glPushMatrix();
-    glScalef(3, 1, 3);
-    glBegin(GL_TRIANGLE_STRIP);
-    glColor3f(1.0f, 1.0f, 1.0f);
-    glNormal3f(0.0f, 1.0f, 0.0f);
-    glVertex3f(-5.0f, 0.0f, -5.0f);
-    glVertex3f(-5.0f, 0.0f, 5.0f);
-    glVertex3f(5.0f, 0.0f, -5.0f);
-    glVertex3f(5.0f, 0.0f, 5.0f);
-    glEnd();
-    glPopMatrix();
-    
-
-    /* TODO#3: Render the airplane    
-     *       1. Render the body.
-     *       2. Render the wings.(Don't forget to assure wings rotate at the center of body.)
-     *       3. Render the tail.
-     * Hint:
-     *       glPushMatrix/glPopMatrix (https://registry.khronos.org/OpenGL-Refpages/gl2.1/xhtml/glPushMatrix.xml)
-     *       glRotatef (https://registry.khronos.org/OpenGL-Refpages/gl2.1/xhtml/glRotate.xml)
-     *       glTranslatef (https://registry.khronos.org/OpenGL-Refpages/gl2.1/xhtml/glTranslate.xml) 
-     *       glColor3f (https://registry.khronos.org/OpenGL-Refpages/gl2.1/xhtml/glColor.xml)
-     *       glScalef (https://registry.khronos.org/OpenGL-Refpages/gl2.1/xhtml/glScale.xml)
-     * Note:
-     *       You may implement functions for drawing components of airplane first
-     *       You should try and think carefully about changing the order of rotate and translate
-     */
-
-    // printf("Render!");
-    render_body();
-    render_wings();
-    render_tail();
-
-#ifdef __APPLE__
-    // Some platform need explicit glFlush
-    glFlush();
-#endif
-    glfwSwapBuffers(window);
+  bool reverseZ = options.reverseZ;
+  if (reverseZ && !GLAD_GL_VERSION_4_5 && !GLAD_GL_ARB_clip_control) {
+    std::cerr << "Reverse-Z needs OpenGL 4.5 or GL_ARB_clip_control, using the standard projection" << std::endl;
+    reverseZ = false;
+  }
+  // Depth 0..1 instead of -1..1, so the reversed depth keeps its precision
+  if (reverseZ) glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+  camera.initialize(OpenGLContext::getAspectRatio(), reverseZ);
+  // Viewports of --views, each with its own camera and culler, only airplanes inside its frustum are drawn
+  BoundingSphere bounds = airplaneBoundingSphere();
+  if (options.stereo) {
+    // Both eyes in one pass, culled once for the camera between them, which sees ipd / 2 less to each side
+    bounds.radius += options.ipd / 2.0f;
+    renderer->setStereo(options.ipd);
+  }
+  SplitScreen splitScreen(options.views, camera, fleet, bounds, options.stereo);
+  splitScreen.resize(OpenGLContext::getWidth(), OpenGLContext::getHeight());
+  std::vector<SplitScreen::View>& views = splitScreen.getViews();
+  std::vector<RenderView> renderViews;
+  for (const SplitScreen::View& view : views) renderViews.push_back({view.camera, &view.culler, &view.lod});
+  LodSelector::setBias(options.lodBias);
+  // Store the views as glfw global variable for callbasks use
+  glfwSetWindowUserPointer(window, &splitScreen);
+
+  if (!options.recordPath.empty()) {
+    inputRecorder = std::make_unique<InputRecorder>(options.recordPath, glfwGetTime());
+    // Replays start from the same projection
+    inputRecorder->resize(glfwGetTime(), OpenGLContext::getWidth(), OpenGLContext::getHeight());
+  }
+  if (!options.replayPath.empty()) inputReplayer = std::make_unique<InputReplayer>(options.replayPath);
+  int replayFrameCount = 0;
+
+  // Camera and airplanes move in fixed steps, frames render between the last two
+  SimulationState initialState{camera.getPosition(), FlightState()};
+  // Replays run on their own clock, see the main loop
+  Simulation simulation(initialState, options.replayPath.empty() ? glfwGetTime() : 0.0);
+  std::unique_ptr<SimulationThread> simulationThread;
+  if (options.simulationThread) simulationThread = std::make_unique<SimulationThread>(initialState, glfwGetTime());
+
+  // Transforms of the immediate path are composed on the CPU and uploaded once per part
+  MatrixStack modelView;
+
+  // Swap interval and frame limiter
+  FramePacer pacer(options.pacing, options.targetFps);
+
+  // CPU time spent on each frame, averaged and printed once per second
+  double cpuFrameTime = 0.0;
+  double lastReportTime = glfwGetTime();
+  int reportFrameCount = 0;
+
+  // Per frame measurements, only collected for benchmark reports
+  BenchReport report;
+  report.renderer = toString(options.renderPath);
+  report.instanceCount = options.instanceCount;
+  report.headless = OpenGLContext::isHeadless();
+  report.pacing = toString(pacer.getMode());
+  for (const SplitScreen::View& view : views) report.views.push_back({toString(view.kind), {}, 0});
+  const int warmupFrameCount = benchmark ? BENCH_WARMUP_FRAMES : 0;
+  // GPU time of each pass, results arrive a few frames late. Passes of several views interleave, so they are only
+  // split for a single view, the airplanes pass covers every view otherwise
+  GpuTimer gpuTimer;
+  GpuTimer* passTimer = views.size() == 1 ? &gpuTimer : nullptr;
+  if (renderer) renderer->setGpuTimer(passTimer);
+  // CPU time of each view this frame, culling and drawing
+  std::vector<double> viewFrameTimes(views.size());
+  int gpuFrameCount = 0;
+  GpuTimer::FrameTimes gpuFrameTime;
+  int gpuReportFrameCount = 0;
+  // Time mouse motion waited before a frame used it
+  double inputLatency = 0.0;
+  int inputReportFrameCount = 0;
+  // Time between swaps, mean and spread are printed once per second
+  double presentInterval = 0.0;
+  double presentIntervalSquares = 0.0;
+  int presentReportFrameCount = 0;
+  // Time spent waiting for input with --idle, and what the last drawn frame showed
+  double idleTime = 0.0;
+  bool animating = true;
+  uint64_t drawnCameraVersion = 0;
+  FlightState drawnFlight;
+
+  // Frames render on their own thread, the main thread waits for events and stamps them the moment they arrive
+  auto renderLoop = [&]() {
+    // Input counted by the last frame, --idle waits for more
+    uint64_t sampledInputCount = 0;
+
+    // Main rendering loop
+    int frameIndex = 0;
+    while (!closeRequested.load(std::memory_order_relaxed)) {
+      PROFILE_SCOPE("frame");
+      if (options.idle && !animating) {
+        // The last frame showed a still scene, sleep until something happens
+        PROFILE_SCOPE("waitForInput");
+        double waitStartTime = glfwGetTime();
+        std::unique_lock<std::mutex> lock(inputMutex);
+        inputArrived.wait_for(lock, std::chrono::duration<double>(IDLE_WAIT_TIMEOUT),
+                              [&] { return inputCount != sampledInputCount; });
+        idleTime += glfwGetTime() - waitStartTime;
+      }
+      double frameStartTime = glfwGetTime();
+      // Late latching: the main thread queued events as they arrived, apply everything up to this moment
+      double sampleTime = frameStartTime;
+      if (inputReplayer) {
+        // Fixed simulated time, one simulation step per frame whatever the frame rate, so every run is the same
+        sampleTime = replayFrameCount++ * Simulation::STEP;
+        RecordedInput recorded;
+        while (inputReplayer->next(sampleTime, recorded)) replayInput(splitScreen, recorded);
+        if (inputReplayer->isFinished() && options.frameCount == 0) requestClose();
+      }
+      KeyState keys;
+      bool resized = false;
+      glm::ivec2 size(0);
+      {
+        std::lock_guard<std::mutex> lock(inputMutex);
+        keys = keysDown;
+        sampledInputCount = inputCount;
+        std::swap(resized, resizePending);
+        size = pendingSize;
+      }
+      if (resized) {
+        OpenGLContext::framebufferResizeCallback(window, size.x, size.y);
+        splitScreen.resize(size.x, size.y);
+      }
+      SimulationInput input = sampleInput(keys, camera);
+      SimulationState state;
+      if (simulationThread) {
+        simulationThread->setInput(input);
+        state = simulationThread->getRenderState(sampleTime);
+      } else {
+        simulation.advance(input, sampleTime);
+        state = simulation.getRenderState();
+      }
+      camera.setPosition(state.cameraPosition);
+      camera.move(sampleTime);
+      splitScreen.follow(state.flight);
+      if (camera.getInputLatency() > 0.0) {
+        inputLatency += camera.getInputLatency();
+        ++inputReportFrameCount;
+      }
+      bool changed = redrawRequested.exchange(false, std::memory_order_relaxed) ||
+                     camera.getVersion() != drawnCameraVersion || state.flight != drawnFlight;
+      bool moving = simulationThread ? simulationThread->isMoving() : simulation.isMoving();
+      animating = changed || moving || input.isActive();
+      if (options.idle && !changed) {
+        // Same picture as the frame on screen, only keep the statistics going
+        if (frameStartTime - lastReportTime >= 1.0) {
+          std::cout << "[" << toString(options.renderPath) << " x" << fleet.size()
+                    << "] idle: " << 100.0 * idleTime / (frameStartTime - lastReportTime) << "%" << std::endl;
+          idleTime = 0.0;
+          lastReportTime = frameStartTime;
+        }
+        pacer.skipFrame();
+        continue;
+      }
+      drawnCameraVersion = camera.getVersion();
+      drawnFlight = state.flight;
+      GLStateCache::beginFrame();
+      DrawStats::beginFrame();
+      gpuTimer.beginFrame();
+      // State only reaches OpenGL when it changes, so setting it every frame is cheap
+      GLStateCache::clearColor(0.0f, 0.0f, 0.0f, 0.0f);
+      GLStateCache::clearDepth(camera.isReverseZ() ? 0.0f : 1.0f);
+      // GL_XXX_BIT can simply "OR" together to use.
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      gpuTimer.endPass(GpuPass::Clear);
+      // Every view culls and picks levels of detail for its own camera, the instanced path then uploads all at once
+      for (std::size_t i = 0; i < views.size(); ++i) {
+        double viewStartTime = glfwGetTime();
+        SplitScreen::View& view = views[i];
+        view.culler.cull(*view.camera, state.flight);
+        view.lod.update(*view.camera, view.viewport.w, fleet, view.culler, state.flight);
+        viewFrameTimes[i] = glfwGetTime() - viewStartTime;
+      }
+      /// TO DO Enable DepthTest
+      GLStateCache::enable(GL_DEPTH_TEST);
+      GLStateCache::depthFunc(camera.isReverseZ() ? GL_GEQUAL : GL_LEQUAL);
+
+
+  //#ifndef DISABLE_LIGHT   
+      // Core profile paths light the scene in their shader, the immediate path in render_scene() for each view
+  //#endif
+
+      /* TODO#4-2: Update 
+       *       You may update position and orientation of airplane here or not.
+       *       Feel free to not follow TA's structure. However, don't violate the spec. 
+       * 
+       * Hint: 
+       * Note:
+       *       You can use `ROTATE_SPEED` and `FLYING_SPEED` as the speed constant. 
+       *       If the rotate/flying speed is too slow or too fast, please change `ROTATE_SPEED` or `FLYING_SPEED` value.
+       *       You should finish keyCallback first.
+       */
+      // Done by Simulation above, state.flight is the interpolated flight of every airplane
+
+      /* TODO#3: Render the airplane    
+       *       1. Render the body.
+       *       2. Render the wings.(Don't forget to assure wings rotate at the center of body.)
+       *       3. Render the tail.
+       * Hint:
+       *       glPushMatrix/glPopMatrix (https://registry.khronos.org/OpenGL-Refpages/gl2.1/xhtml/glPushMatrix.xml)
+       *       glRotatef (https://registry.khronos.org/OpenGL-Refpages/gl2.1/xhtml/glRotate.xml)
+       *       glTranslatef (https://registry.khronos.org/OpenGL-Refpages/gl2.1/xhtml/glTranslate.xml) 
+       *       glColor3f (https://registry.khronos.org/OpenGL-Refpages/gl2.1/xhtml/glColor.xml)
+       *       glScalef (https://registry.khronos.org/OpenGL-Refpages/gl2.1/xhtml/glScale.xml)
+       * Note:
+       *       You may implement functions for drawing components of airplane first
+       *       You should try and think carefully about changing the order of rotate and translate
+       */
+
+      // printf("Render!");
+      // Wing animation and instance uploads are shared by every view
+      if (renderer) renderer->beginFrame(state.flight, renderViews);
+      for (std::size_t i = 0; i < views.size(); ++i) {
+        PROFILE_SCOPE("render_view");
+        double viewStartTime = glfwGetTime();
+        const glm::ivec4& viewport = views[i].viewport;
+        glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+        if (renderer) {
+          renderer->render(i);
+        } else {
+          render_scene(modelView, *views[i].camera, fleet, views[i].culler, views[i].lod, state.flight, passTimer);
+        }
+        viewFrameTimes[i] += glfwGetTime() - viewStartTime;
+      }
+      if (!passTimer) gpuTimer.endPass(GpuPass::Airplanes);
+      DrawStats::endFrame();
+
+  #ifdef __APPLE__
+      // Some platform need explicit glFlush
+      glFlush();
+  #endif
+      // Swap may block on vsync, so it is not part of the CPU frame time
+      double frameEndTime = glfwGetTime();
+      cpuFrameTime += frameEndTime - frameStartTime;
+      gpuTimer.endFrame();
+      const bool measuredFrame = benchmark && frameIndex >= warmupFrameCount;
+      if (measuredFrame) {
+        report.cpuFrameTimes.push_back(1000.0 * (frameEndTime - frameStartTime));
+        report.drawCalls.push_back(DrawStats::getDrawCallCount());
+        report.vertices.push_back(DrawStats::getVertexCount());
+      }
+      std::size_t drawnCount = 0;
+      std::array<std::size_t, LOD_LEVEL_COUNT> levelCounts = {};
+      for (std::size_t i = 0; i < views.size(); ++i) {
+        views[i].cpuTime += viewFrameTimes[i];
+        if (measuredFrame) report.views[i].cpuTimes.push_back(1000.0 * viewFrameTimes[i]);
+        drawnCount += views[i].culler.getVisibleCount();
+        for (int level = 0; level < LOD_LEVEL_COUNT; ++level) {
+          levelCounts[level] += views[i].lod.getLevelCounts()[level];
+        }
+      }
+      for (const GpuTimer::FrameTimes& frame : gpuTimer.takeResults()) {
+        if (benchmark && gpuFrameCount++ >= warmupFrameCount) report.addGpuFrame(frame);
+        gpuFrameTime.total += frame.total;
+        for (int i = 0; i < GPU_PASS_COUNT; ++i) gpuFrameTime.passes[i] += frame.passes[i];
+        ++gpuReportFrameCount;
+      }
+      ++reportFrameCount;
+      if (frameEndTime - lastReportTime >= 1.0) {
+        std::cout << "[" << toString(options.renderPath) << " x" << fleet.size()
+                  << "] CPU frame time: " << 1000.0 * cpuFrameTime / reportFrameCount
+                  << " ms, GL state calls dropped: " << GLStateCache::getFilteredCount() << " of "
+                  << GLStateCache::getFilteredCount() + GLStateCache::getIssuedCount() << ", airplanes drawn: "
+                  << drawnCount << " of " << fleet.size() * views.size();
+        if (gpuReportFrameCount > 0) {
+          std::cout << ", GPU frame time: " << gpuFrameTime.total / gpuReportFrameCount << " ms (";
+          for (int i = 0; i < GPU_PASS_COUNT; ++i) {
+            std::cout << (i > 0 ? ", " : "") << toString(static_cast<GpuPass>(i)) << " "
+                      << gpuFrameTime.passes[i] / gpuReportFrameCount;
+          }
+          std::cout << ")";
+        }
+        if (presentReportFrameCount > 0) {
+          double mean = presentInterval / presentReportFrameCount;
+          double variance = std::max(0.0, presentIntervalSquares / presentReportFrameCount - mean * mean);
+          std::cout << ", present interval (" << toString(pacer.getMode()) << "): " << mean << " ms, jitter "
+                    << std::sqrt(variance) << " ms";
+        }
+        if (inputReportFrameCount > 0) {
+          std::cout << ", input latency: " << 1000.0 * inputLatency / inputReportFrameCount << " ms";
+        }
+        std::cout << ", fuselage segments:";
+        for (int level = 0; level < LOD_LEVEL_COUNT; ++level) {
+          std::cout << (level > 0 ? ", " : " ") << LOD_SEGMENTS[level] << " x" << levelCounts[level];
+        }
+        if (views.size() > 1) {
+          // CPU cost of each viewport, culling and drawing
+          std::cout << ", views:";
+          for (SplitScreen::View& view : views) {
+            std::cout << (&view == &views.front() ? " " : ", ") << toString(view.kind) << " "
+                      << 1000.0 * view.cpuTime / reportFrameCount << " ms (" << view.culler.getVisibleCount()
+                      << " drawn)";
+            view.cpuTime = 0.0;
+          }
+        }
+        if (options.idle) std::cout << ", idle: " << 100.0 * idleTime / (frameEndTime - lastReportTime) << "%";
+        std::cout << std::endl;
+        idleTime = 0.0;
+        inputLatency = 0.0;
+        inputReportFrameCount = 0;
+        presentInterval = 0.0;
+        presentIntervalSquares = 0.0;
+        presentReportFrameCount = 0;
+        gpuFrameTime = {};
+        gpuReportFrameCount = 0;
+        cpuFrameTime = 0.0;
+        reportFrameCount = 0;
+        lastReportTime = frameEndTime;
+      }
+      bool lastFrame = options.frameCount > 0 && ++frameIndex >= options.frameCount + warmupFrameCount;
+      if (lastFrame && !options.capturePath.empty()) OpenGLContext::saveFramebuffer(options.capturePath);
+      pacer.waitForDeadline();
+      {
+        PROFILE_SCOPE("glfwSwapBuffers");
+        glfwSwapBuffers(window);
+      }
+      double interval = pacer.framePresented();
+      if (interval > 0.0) {
+        presentInterval += interval;
+        presentIntervalSquares += interval * interval;
+        ++presentReportFrameCount;
+        if (measuredFrame) report.presentIntervals.push_back(interval);
+      }
+      if (lastFrame) requestClose();
+    }
+
+    if (PROFILE_DUMP(PROFILE_TRACE_PATH)) std::cout << "Profile written to " PROFILE_TRACE_PATH << std::endl;
+
+    if (benchmark) {
+      // Culling and levels of detail of the last frame
+      for (std::size_t i = 0; i < views.size(); ++i) {
+        for (int level = 0; level < LOD_LEVEL_COUNT; ++level) {
+          report.lodLevelCounts[level] += views[i].lod.getLevelCounts()[level];
+        }
+        report.views[i].airplanesDrawn = views[i].culler.getVisibleCount();
+        report.airplanesDrawn += views[i].culler.getVisibleCount();
+        report.airplanesCulled += views[i].culler.getCulledCount();
+      }
+      gpuTimer.finish();
+      for (const GpuTimer::FrameTimes& frame : gpuTimer.takeResults()) {
+        if (gpuFrameCount++ >= warmupFrameCount) report.addGpuFrame(frame);
+      }
+      if (options.jsonPath.empty()) {
+        report.write(reportOut);
+      } else {
+        std::ofstream file(options.jsonPath);
+        report.write(file);
+        if (!file) THROW_EXCEPTION(std::runtime_error, "Failed to write " + options.jsonPath);
+      }
+    }
+  };
+  std::atomic<bool> renderFinished{false};
+  std::exception_ptr renderError;
+  glfwMakeContextCurrent(nullptr);
+  std::thread renderThread([&] {
+    glfwMakeContextCurrent(window);
+    try {
+      renderLoop();
+    } catch (...) {
+      renderError = std::current_exception();
+    }
+    glfwMakeContextCurrent(nullptr);
+    renderFinished.store(true);
+    glfwPostEmptyEvent();
+  });
+  // Headless windows get no input, and glfwWaitEvents returns at once on the null platform of OSMesa builds
+  if (!OpenGLContext::isHeadless()) {
+    while (!renderFinished.load()) {
+      glfwWaitEvents();
+      if (glfwWindowShouldClose(window)) requestClose();
+    }
+  }
+  renderThread.join();
+  // GL objects are released on this thread
+  glfwMakeContextCurrent(window);
+  if (renderError) std::rethrow_exception(renderError);
+
+  if (inputRecorder) {
+    std::cout << "Recorded " << inputRecorder->getCount() << " inputs to " << options.recordPath << std::endl;
+    inputRecorder.reset();
   }
   return 0;
 }
@@ -0,0 +1,67 @@
+#include "matrix_stack.h"
+
+#include <stdexcept>
+
+#include <glm/gtc/matrix_transform.hpp>
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define MATRIX_STACK_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace {
+inline glm::mat4 multiplyMatrix(const glm::mat4& a, const glm::mat4& b) {
+#ifdef MATRIX_STACK_USE_SSE
+  // Column j of the result is a * b[j], a linear combination of the columns of a
+  const __m128 a0 = _mm_loadu_ps(&a[0][0]);
+  const __m128 a1 = _mm_loadu_ps(&a[1][0]);
+  const __m128 a2 = _mm_loadu_ps(&a[2][0]);
+  const __m128 a3 = _mm_loadu_ps(&a[3][0]);
+  glm::mat4 result;
+  for (int j = 0; j < 4; ++j) {
+    __m128 column = _mm_mul_ps(a0, _mm_set1_ps(b[j][0]));
+    column = _mm_add_ps(column, _mm_mul_ps(a1, _mm_set1_ps(b[j][1])));
+    column = _mm_add_ps(column, _mm_mul_ps(a2, _mm_set1_ps(b[j][2])));
+    column = _mm_add_ps(column, _mm_mul_ps(a3, _mm_set1_ps(b[j][3])));
+    _mm_storeu_ps(&result[j][0], column);
+  }
+  return result;
+#else
+  return a * b;
+#endif
+}
+}  // namespace
+
+MatrixStack::MatrixStack() {
+  // Deep enough for camera -> airplane -> part without reallocating
+  stack.reserve(8);
+  stack.emplace_back(1.0f);
+}
+
+void MatrixStack::push() { stack.push_back(stack.back()); }
+
+void MatrixStack::pop() {
+  if (stack.size() <= 1) THROW_EXCEPTION(std::underflow_error, "MatrixStack::pop on the last matrix");
+  stack.pop_back();
+}
+
+void MatrixStack::load(const glm::mat4& matrix) { stack.back() = matrix; }
+
+void MatrixStack::multiply(const glm::mat4& matrix) { stack.back() = multiplyMatrix(stack.back(), matrix); }
+
+void MatrixStack::translate(float x, float y, float z) {
+  // Only the last column changes, no full product needed
+  glm::mat4& m = stack.back();
+  m[3] = m[0] * x + m[1] * y + m[2] * z + m[3];
+}
+
+void MatrixStack::rotate(float angle, float x, float y, float z) {
+  glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(x, y, z));
+  stack.back() = multiplyMatrix(stack.back(), rotation);
+}
+
+void MatrixStack::scale(float x, float y, float z) {
+  glm::mat4& m = stack.back();
+  m[0] *= x;
+  m[1] *= y;
+  m[2] *= z;
+}
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <GLFW/glfw3.h>
+#define GLAD_GL_IMPLEMENTATION
+#include <glad/gl.h>
+#undef GLAD_GL_IMPLEMENTATION
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "matrix_stack.h"
+#include "opengl_context.h"
+
+// Compare the legacy matrix stack of the driver with MatrixStack + one glLoadMatrixf per part.
+// Nothing is drawn, only the transform traffic of the immediate path is measured.
+namespace {
+constexpr int AIRPLANE_COUNT = 10000;
+constexpr int PART_COUNT = 4;
+constexpr int ROUNDS = 20;
+
+using Clock = std::chrono::steady_clock;
+
+void legacyAirplane(const glm::mat4& model) {
+  glPushMatrix();
+  glMultMatrixf(glm::value_ptr(model));
+  // Body
+  glPushMatrix();
+  glTranslatef(0.0f, 0.5f, 0.0f);
+  glRotatef(-90.0f, 1.0f, 0.0f, 0.0f);
+  glPopMatrix();
+  // Wings
+  glPushMatrix();
+  glTranslatef(2.0f, 0.5f, 0.0f);
+  glPopMatrix();
+  glPushMatrix();
+  glTranslatef(-2.0f, 0.5f, 0.0f);
+  glPopMatrix();
+  // Tail
+  glPushMatrix();
+  glTranslatef(0.0f, 0.5f, 2.0f);
+  glPopMatrix();
+  glPopMatrix();
+}
+
+void stackAirplane(MatrixStack& stack, const glm::mat4& model) {
+  stack.push();
+  stack.multiply(model);
+  // Body
+  stack.push();
+  stack.translate(0.0f, 0.5f, 0.0f);
+  stack.rotate(-90.0f, 1.0f, 0.0f, 0.0f);
+  glLoadMatrixf(stack.data());
+  stack.pop();
+  // Wings
+  stack.push();
+  stack.translate(2.0f, 0.5f, 0.0f);
+  glLoadMatrixf(stack.data());
+  stack.pop();
+  stack.push();
+  stack.translate(-2.0f, 0.5f, 0.0f);
+  glLoadMatrixf(stack.data());
+  stack.pop();
+  // Tail
+  stack.push();
+  stack.translate(0.0f, 0.5f, 2.0f);
+  glLoadMatrixf(stack.data());
+  stack.pop();
+  stack.pop();
+}
+
+template <typename Function>
+double nanosecondsPerPart(Function&& function) {
+  double best = 1e300;
+  for (int round = 0; round < ROUNDS; ++round) {
+    glFinish();
+    auto start = Clock::now();
+    function();
+    glFinish();
+    std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+    best = std::min(best, elapsed.count());
+  }
+  return best / (AIRPLANE_COUNT * PART_COUNT);
+}
+}  // namespace
+
+int main() {
+  // The legacy matrix stack only exists in a compatibility profile
+#ifdef __APPLE__
+  OpenGLContext::createContext(21, GLFW_OPENGL_ANY_PROFILE);
+#else
+  OpenGLContext::createContext(43, GLFW_OPENGL_COMPAT_PROFILE);
+#endif
+  glfwHideWindow(OpenGLContext::getWindow());
+
+  std::vector<glm::mat4> models;
+  models.reserve(AIRPLANE_COUNT);
+  for (int i = 0; i < AIRPLANE_COUNT; ++i) {
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(i % 100 * 10.0f, 0.0f, i / 100 * 6.0f));
+    models.push_back(glm::rotate(model, glm::radians(static_cast<float>(i)), glm::vec3(0.0f, 1.0f, 0.0f)));
+  }
+  glm::mat4 view = glm::lookAt(glm::vec3(0, 5, 10), glm::vec3(0), glm::vec3(0, 1, 0));
+
+  glMatrixMode(GL_MODELVIEW);
+  double legacy = nanosecondsPerPart([&] {
+    glLoadMatrixf(glm::value_ptr(view));
+    for (const glm::mat4& model : models) legacyAirplane(model);
+  });
+
+  MatrixStack stack;
+  double cpu = nanosecondsPerPart([&] {
+    stack.load(view);
+    for (const glm::mat4& model : models) stackAirplane(stack, model);
+  });
+
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << AIRPLANE_COUNT << " airplanes x " << PART_COUNT << " parts, best of " << ROUNDS << " rounds"
+            << std::endl;
+  std::cout << "glPushMatrix / glTranslatef / glRotatef: " << legacy << " ns per part" << std::endl;
+  std::cout << "MatrixStack + glLoadMatrixf:            " << cpu << " ns per part" << std::endl;
+  return 0;
+}
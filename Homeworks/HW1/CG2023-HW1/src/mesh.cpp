@@ -0,0 +1,206 @@
+#include "mesh.h"
+
+#include "cylinder_mesh.h"
+#include "draw_stats.h"
+#include "gl_state_cache.h"
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <utility>
+
+namespace {
+/// @brief Append a quad p0 p1 p2 p3 (counter-clockwise around normal) as two triangles.
+void addQuad(MeshData& data, glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, glm::vec3 p3, glm::vec3 normal) {
+  GLuint base = static_cast<GLuint>(data.vertices.size());
+  data.vertices.insert(data.vertices.end(), {{p0, normal}, {p1, normal}, {p2, normal}, {p3, normal}});
+  data.indices.insert(data.indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+}
+
+/// @brief Append a box face, u and v are half extents along the face with cross(u, v) pointing outward.
+void addBoxFace(MeshData& data, glm::vec3 center, glm::vec3 u, glm::vec3 v) {
+  addQuad(data, center - u - v, center + u - v, center + u + v, center - u + v, glm::normalize(glm::cross(u, v)));
+}
+}  // namespace
+
+namespace mesh {
+MeshData cylinder(float radius, float height, int segments) {
+  const UnitCircle circle(segments);
+  return cylinder(radius, height, circle.data(), segments);
+}
+
+MeshData cylinder(float radius, float height, const CirclePoint* circle, int segments) {
+  MeshData data;
+  float halfHeight = height / 2.0f;
+  // Caps, a fan around the center vertex
+  for (float y : {halfHeight, -halfHeight}) {
+    glm::vec3 normal(0.0f, y > 0 ? 1.0f : -1.0f, 0.0f);
+    GLuint center = static_cast<GLuint>(data.vertices.size());
+    data.vertices.push_back({glm::vec3(0.0f, y, 0.0f), normal});
+    for (int i = 0; i < segments; i++) {
+      data.vertices.push_back({glm::vec3(radius * circle[i].x, y, radius * circle[i].z), normal});
+    }
+    for (int i = 0; i < segments; i++) {
+      GLuint current = center + 1 + i;
+      GLuint next = center + 1 + (i + 1) % segments;
+      // Angle grows from +X to +Z, which is clockwise seen from +Y
+      if (y > 0)
+        data.indices.insert(data.indices.end(), {center, next, current});
+      else
+        data.indices.insert(data.indices.end(), {center, current, next});
+    }
+  }
+  // Side, one bottom / top pair per segment boundary, the seam is duplicated
+  GLuint side = static_cast<GLuint>(data.vertices.size());
+  for (int i = 0; i <= segments; i++) {
+    glm::vec3 normal(circle[i].x, 0.0f, circle[i].z);
+    data.vertices.push_back({glm::vec3(radius * normal.x, -halfHeight, radius * normal.z), normal});
+    data.vertices.push_back({glm::vec3(radius * normal.x, halfHeight, radius * normal.z), normal});
+  }
+  for (int i = 0; i < segments; i++) {
+    GLuint bottom = side + 2 * i, top = bottom + 1;
+    GLuint nextBottom = bottom + 2, nextTop = bottom + 3;
+    data.indices.insert(data.indices.end(), {bottom, top, nextTop, bottom, nextTop, nextBottom});
+  }
+  return data;
+}
+
+MeshData cuboid(float length, float width, float height) {
+  MeshData data;
+  glm::vec3 x(length / 2.0f, 0.0f, 0.0f);
+  glm::vec3 y(0.0f, height / 2.0f, 0.0f);
+  glm::vec3 z(0.0f, 0.0f, width / 2.0f);
+  addBoxFace(data, z, x, y);    // Front
+  addBoxFace(data, -z, y, x);   // Back
+  addBoxFace(data, x, y, z);    // Right
+  addBoxFace(data, -x, z, y);   // Left
+  addBoxFace(data, y, z, x);    // Top
+  addBoxFace(data, -y, x, z);   // Bottom
+  return data;
+}
+
+MeshData tetrahedron(float bottomEdge, float height1, float height2) {
+  MeshData data;
+  const glm::vec3 apex(0.0f, 0.0f, 0.0f);
+  const glm::vec3 left(bottomEdge / 2.0f, 0.0f, height1);
+  const glm::vec3 right(-bottomEdge / 2.0f, 0.0f, height1);
+  const glm::vec3 bottom(0.0f, -height2, height1);
+  const glm::vec3 centroid = (apex + left + right + bottom) / 4.0f;
+  const glm::vec3 faces[4][3] = {
+      {apex, left, right},
+      {apex, bottom, left},
+      {apex, bottom, right},
+      {right, bottom, left},
+  };
+  // Flat shaded, every face gets its own vertices
+  for (const auto& face : faces) {
+    glm::vec3 p0 = face[0], p1 = face[1], p2 = face[2];
+    glm::vec3 normal = glm::normalize(glm::cross(p1 - p0, p2 - p0));
+    if (glm::dot(normal, (p0 + p1 + p2) / 3.0f - centroid) < 0) {
+      std::swap(p1, p2);
+      normal = -normal;
+    }
+    GLuint base = static_cast<GLuint>(data.vertices.size());
+    data.vertices.insert(data.vertices.end(), {{p0, normal}, {p1, normal}, {p2, normal}});
+    data.indices.insert(data.indices.end(), {base, base + 1, base + 2});
+  }
+  return data;
+}
+
+MeshData board(float halfSize) {
+  MeshData data;
+  addBoxFace(data, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, halfSize), glm::vec3(halfSize, 0.0f, 0.0f));
+  return data;
+}
+BoundingSphere boundingSphere(const MeshData& data, const glm::mat4& transform) {
+  if (data.vertices.empty()) return {};
+  glm::vec3 low(std::numeric_limits<float>::max());
+  glm::vec3 high(std::numeric_limits<float>::lowest());
+  for (const Vertex& vertex : data.vertices) {
+    glm::vec3 position(transform * glm::vec4(vertex.position, 1.0f));
+    low = glm::min(low, position);
+    high = glm::max(high, position);
+  }
+  BoundingSphere sphere;
+  sphere.center = 0.5f * (low + high);
+  for (const Vertex& vertex : data.vertices) {
+    glm::vec3 position(transform * glm::vec4(vertex.position, 1.0f));
+    sphere.radius = std::max(sphere.radius, glm::distance(sphere.center, position));
+  }
+  return sphere;
+}
+}  // namespace mesh
+
+UnitCircle::UnitCircle(int segments) {
+  switch (segments) {
+    case 8:
+      points = CylinderMesh<8>::circle.data();
+      return;
+    case 16:
+      points = CylinderMesh<16>::circle.data();
+      return;
+    case 32:
+      points = CylinderMesh<32>::circle.data();
+      return;
+    case 64:
+      points = CylinderMesh<64>::circle.data();
+      return;
+    case 128:
+      points = CylinderMesh<128>::circle.data();
+      return;
+    default:
+      break;
+  }
+  // Runtime fallback, still only one cos / sin pair per segment
+  storage.resize(segments + 1);
+  float angleIncrement = 2.0f * utils::PI<float>() / segments;
+  for (int i = 0; i < segments; ++i) {
+    float angle = static_cast<float>(i) * angleIncrement;
+    storage[i] = {std::cos(angle), std::sin(angle)};
+  }
+  storage[segments] = storage[0];
+  points = storage.data();
+}
+
+Mesh::Mesh(const MeshData& data)
+    : indexCount(static_cast<GLsizei>(data.indices.size())),
+      vertexCount(static_cast<GLsizei>(data.vertices.size())) {
+  glGenVertexArrays(1, &vao);
+  glGenBuffers(1, &vbo);
+  glGenBuffers(1, &ibo);
+
+  GLStateCache::bindVertexArray(vao);
+  GLStateCache::bindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBufferData(GL_ARRAY_BUFFER, data.vertices.size() * sizeof(Vertex), data.vertices.data(), GL_STATIC_DRAW);
+  GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.indices.size() * sizeof(GLuint), data.indices.data(), GL_STATIC_DRAW);
+  bindAttributes();
+}
+
+void Mesh::bindAttributes() const {
+  GLStateCache::bindBuffer(GL_ARRAY_BUFFER, vbo);
+  glEnableVertexAttribArray(POSITION_ATTRIBUTE);
+  glVertexAttribPointer(POSITION_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                        reinterpret_cast<const void*>(offsetof(Vertex, position)));
+  glEnableVertexAttribArray(NORMAL_ATTRIBUTE);
+  glVertexAttribPointer(NORMAL_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                        reinterpret_cast<const void*>(offsetof(Vertex, normal)));
+  GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+}
+
+Mesh::~Mesh() {
+  glDeleteVertexArrays(1, &vao);
+  glDeleteBuffers(1, &vbo);
+  glDeleteBuffers(1, &ibo);
+  GLStateCache::invalidate();
+}
+
+void Mesh::draw(GLsizei instanceCount) const {
+  GLStateCache::bindVertexArray(vao);
+  if (instanceCount == 1) {
+    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, nullptr);
+  } else {
+    glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, nullptr, instanceCount);
+  }
+  DrawStats::record(indexCount, instanceCount);
+}
@@ -0,0 +1,52 @@
+#include "mesh_cache.h"
+
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+
+namespace {
+inline void hashCombine(std::size_t& seed, std::size_t value) {
+  seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+}
+
+}  // namespace
+
+MeshData generatePrimitive(const PrimitiveKey& key) {
+  const auto& d = key.dimensions;
+  switch (key.shape) {
+    case Primitive::Cylinder:
+      return mesh::cylinder(d[0], d[1], key.segments);
+    case Primitive::Cuboid:
+      return mesh::cuboid(d[0], d[1], d[2]);
+    case Primitive::Tetrahedron:
+      return mesh::tetrahedron(d[0], d[1], d[2]);
+    case Primitive::Board:
+      return mesh::board(d[0]);
+  }
+  THROW_EXCEPTION(std::invalid_argument, "Unknown primitive");
+}
+
+std::size_t PrimitiveKeyHash::operator()(const PrimitiveKey& key) const {
+  std::size_t seed = std::hash<int>()(static_cast<int>(key.shape));
+  for (float dimension : key.dimensions) {
+    // Hash the bit pattern, but -0 and +0 compare equal so they must hash equal too
+    if (dimension == 0.0f) dimension = 0.0f;
+    uint32_t bits;
+    std::memcpy(&bits, &dimension, sizeof(bits));
+    hashCombine(seed, std::hash<uint32_t>()(bits));
+  }
+  hashCombine(seed, std::hash<int>()(key.segments));
+  return seed;
+}
+
+MeshCache::Handle MeshCache::get(const PrimitiveKey& key) {
+  auto it = meshes.find(key);
+  if (it != meshes.end()) {
+    ++hitCount;
+    return it->second;
+  }
+  ++missCount;
+  Handle handle = std::make_shared<const PrimitiveMesh>(generatePrimitive(key));
+  meshes.emplace(key, handle);
+  return handle;
+}
@@ -1,14 +1,20 @@
 #include "opengl_context.h"
 
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <stdexcept>
+#include <vector>
+
+#include "gl_debug_log.h"
+#include "gl_state_cache.h"
 
 GLFWwindow* OpenGLContext::window = nullptr;
 int OpenGLContext::refresh_rate = 60;
 int OpenGLContext::major_version = 4;
 int OpenGLContext::minor_version = 1;
 int OpenGLContext::profile = GLFW_OPENGL_COMPAT_PROFILE;
+bool OpenGLContext::headless = false;
 int OpenGLContext::framebuffer_width = 1280;
 int OpenGLContext::framebuffer_height = 720;
 
@@ -97,8 +103,16 @@ void printSeverityEnum(GLenum severity) {
   std::cerr << std::endl;
 }
 
-void GLAPIENTRY errorCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei, const GLchar* message,
-                              const void*) {
+/// @brief Runs on the writer thread of GLDebugLog
+void writeDebugMessage(const GLDebugMessage& message) {
+  std::cerr << std::endl << "Id: " << message.id << " Message : " << message.text.data() << std::endl;
+  printSeverityEnum(message.severity);
+  printSourceEnum(message.source);
+  printTypeEnum(message.type);
+}
+
+void GLAPIENTRY errorCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+                              const GLchar* message, const void*) {
   if (id == 131169 ||  // Allocate framebuffer
       id == 131185 ||  // Allocate buffer
       id == 131218 ||  // Shader recompile
@@ -106,14 +120,13 @@ void GLAPIENTRY errorCallback(GLenum source, GLenum type, GLuint id, GLenum seve
       id == 13         // GL_LIGHTH is deprecated in open GL 3 (deprecated fixed function lights pipleine)
   )
     return;
-  std::cerr << std::endl << "Id: " << id << " Message : " << message << std::endl;
-  printSeverityEnum(severity);
-  printSourceEnum(source);
-  printTypeEnum(type);
+  // Only copy the message, formatting and I/O happen on the writer thread
+  GLDebugLog::push(source, type, id, severity, length, message);
 }
 }  // namespace
 
 OpenGLContext::OpenGLContext() {
+  PROFILE_SCOPE("OpenGLContext::OpenGLContext");
   // Initialize GLFW
   if (glfwInit() == GLFW_FALSE) {
     THROW_EXCEPTION(std::runtime_error, "Failed to initialize GLFW!");
@@ -121,7 +134,11 @@ OpenGLContext::OpenGLContext() {
   // Setup context property
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, major_version);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minor_version);
-  if (OpenGLContext::profile == GLFW_OPENGL_CORE_PROFILE) {
+  if (OpenGLContext::headless) {
+    // Software rendering into an offscreen buffer, OSMesa rejects forward compatible contexts
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+  } else if (OpenGLContext::profile == GLFW_OPENGL_CORE_PROFILE) {
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
   }
   glfwWindowHint(GLFW_OPENGL_PROFILE, OpenGLContext::profile);
@@ -156,19 +173,21 @@ OpenGLContext::OpenGLContext() {
   // OK, everything works fine
   // ----------------------------------------------------------
   // Enable some OpenGL feature
-  glEnable(GL_DEPTH_TEST);
-  glEnable(GL_CULL_FACE);
-  glClearColor(0, 0, 0, 1);
+  GLStateCache::enable(GL_DEPTH_TEST);
+  GLStateCache::enable(GL_CULL_FACE);
+  GLStateCache::clearColor(0, 0, 0, 1);
 }
 
 OpenGLContext::~OpenGLContext() {
   if (window != nullptr) glfwDestroyWindow(window);
   glfwTerminate();
+  GLDebugLog::stop();
 }
 
-void OpenGLContext::createContext(int GLversion, int profile) {
+void OpenGLContext::createContext(int GLversion, int profile, bool headless) {
   // We should only initialize once
   if (window == nullptr) {
+    OpenGLContext::headless = headless;
     OpenGLContext::major_version = GLversion / 10;
     OpenGLContext::minor_version = GLversion % 10;
     if (GLversion < 32)
@@ -196,6 +215,8 @@ void OpenGLContext::printSystemInfo() {
             << ": " << refresh_rate << " Hz" << std::endl;
 }
 
+void OpenGLContext::setSwapInterval(int interval) { glfwSwapInterval(interval); }
+
 void OpenGLContext::framebufferResizeCallback(GLFWwindow*, int width, int height) {
   framebuffer_width = width;
   framebuffer_height = height;
@@ -210,8 +231,9 @@ void OpenGLContext::enableDebugCallback() {
     if (glDebugMessageCallback != nullptr) {
       std::cout << "Debug context enabled, it may hurt performance." << std::endl;
       std::cout << "Build in release mode to disable debugging." << std::endl;
+      // The callback is thread safe, so the driver may report asynchronously instead of serializing every call
+      GLDebugLog::start(writeDebugMessage);
       glEnable(GL_DEBUG_OUTPUT);
-      glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
       glDebugMessageCallback(errorCallback, nullptr);
     } else {
       std::cout << "Your system does not support debug output." << std::endl;
@@ -221,3 +243,20 @@ void OpenGLContext::enableDebugCallback() {
     std::cout << "You should build with debug mode to enable this feature." << std::endl;
   }
 }
+
+void OpenGLContext::saveFramebuffer(const std::string& path) {
+  std::vector<unsigned char> pixels(static_cast<std::size_t>(framebuffer_width) * framebuffer_height * 3);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadBuffer(GL_BACK);
+  glReadPixels(0, 0, framebuffer_width, framebuffer_height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file) THROW_EXCEPTION(std::runtime_error, "Cannot open " + path);
+  file << "P6\n" << framebuffer_width << " " << framebuffer_height << "\n255\n";
+  // OpenGL rows start at the bottom, PPM rows start at the top
+  const std::size_t rowSize = static_cast<std::size_t>(framebuffer_width) * 3;
+  for (int row = framebuffer_height - 1; row >= 0; --row) {
+    file.write(reinterpret_cast<const char*>(pixels.data() + row * rowSize), rowSize);
+  }
+  if (!file) THROW_EXCEPTION(std::runtime_error, "Failed to write " + path);
+}
@@ -0,0 +1,187 @@
+#include "options.h"
+
+#include <charconv>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "airplane.h"
+#include "utils.h"
+
+namespace {
+RenderPath parseRenderPath(std::string_view value) {
+  if (value == "immediate") return RenderPath::Immediate;
+  if (value == "retained") return RenderPath::Retained;
+  if (value == "instanced") return RenderPath::Instanced;
+  THROW_EXCEPTION(std::invalid_argument, "Unknown renderer: " + std::string(value));
+}
+
+PacingMode parsePacingMode(std::string_view value) {
+  if (value == "vsync") return PacingMode::VSync;
+  if (value == "adaptive") return PacingMode::Adaptive;
+  if (value == "uncapped") return PacingMode::Uncapped;
+  if (value == "limit") return PacingMode::Limit;
+  THROW_EXCEPTION(std::invalid_argument, "Unknown pacing mode: " + std::string(value));
+}
+
+ViewKind parseViewKind(std::string_view value) {
+  if (value == "main") return ViewKind::Main;
+  if (value == "chase") return ViewKind::Chase;
+  if (value == "overhead") return ViewKind::Overhead;
+  if (value == "cockpit") return ViewKind::Cockpit;
+  THROW_EXCEPTION(std::invalid_argument, "Unknown view: " + std::string(value));
+}
+
+std::vector<ViewKind> parseViews(std::string_view value) {
+  std::vector<ViewKind> views;
+  while (true) {
+    std::string_view::size_type comma = value.find(',');
+    views.push_back(parseViewKind(value.substr(0, comma)));
+    if (comma == std::string_view::npos) break;
+    value.remove_prefix(comma + 1);
+  }
+  if (views.size() > MAX_VIEW_COUNT) {
+    THROW_EXCEPTION(std::invalid_argument, "--views takes at most " + std::to_string(MAX_VIEW_COUNT) + " views");
+  }
+  return views;
+}
+
+bool parseSimulationThread(std::string_view value) {
+  if (value == "inline") return false;
+  if (value == "thread") return true;
+  THROW_EXCEPTION(std::invalid_argument, "Unknown simulation mode: " + std::string(value));
+}
+
+int parseInt(std::string_view name, std::string_view value, int min, int max) {
+  int result = 0;
+  auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+  if (error != std::errc() || end != value.data() + value.size() || result < min || result > max) {
+    THROW_EXCEPTION(std::invalid_argument, std::string(name) + " expects an integer in [" + std::to_string(min) +
+                                               ", " + std::to_string(max) + "], got: " + std::string(value));
+  }
+  return result;
+}
+float parseFloat(std::string_view name, std::string_view value, float min, float max) {
+  std::string text(value);
+  char* end = nullptr;
+  float result = std::strtof(text.c_str(), &end);
+  if (text.empty() || end != text.c_str() + text.size() || !(result >= min && result <= max)) {
+    THROW_EXCEPTION(std::invalid_argument, std::string(name) + " expects a number in [" + std::to_string(min) + ", " +
+                                               std::to_string(max) + "], got: " + text);
+  }
+  return result;
+}
+}  // namespace
+
+Options parseOptions(int argc, char** argv) {
+  Options options;
+  if (const char* headless = std::getenv("HW1_HEADLESS")) {
+    options.headless = *headless != '\0' && std::string_view(headless) != "0";
+  }
+  for (int i = 1; i < argc; ++i) {
+    std::string_view argument(argv[i]);
+    std::string_view::size_type separator = argument.find('=');
+    std::string_view name = argument.substr(0, separator);
+    std::string_view value = separator == std::string_view::npos ? "" : argument.substr(separator + 1);
+    if (name == "--renderer") {
+      options.renderPath = parseRenderPath(value);
+    } else if (name == "--instances") {
+      options.instanceCount = parseInt(name, value, 1, MAX_AIRPLANE_COUNT);
+    } else if (argument == "--headless") {
+      options.headless = true;
+    } else if (argument == "--idle") {
+      options.idle = true;
+    } else if (argument == "--reverse-z") {
+      options.reverseZ = true;
+    } else if (argument == "--stereo") {
+      options.stereo = true;
+    } else if (name == "--ipd") {
+      options.ipd = parseFloat(name, value, 0.0f, 10.0f);
+    } else if (name == "--lod-bias") {
+      options.lodBias = parseFloat(name, value, -4.0f, 4.0f);
+    } else if (name == "--frames") {
+      options.frameCount = parseInt(name, value, 0, std::numeric_limits<int>::max());
+    } else if (name == "--capture" && !value.empty()) {
+      options.capturePath = value;
+    } else if (name == "--json" && !value.empty()) {
+      options.jsonPath = value;
+    } else if (name == "--record" && !value.empty()) {
+      options.recordPath = value;
+    } else if (name == "--replay" && !value.empty()) {
+      options.replayPath = value;
+    } else if (name == "--simulation") {
+      options.simulationThread = parseSimulationThread(value);
+    } else if (name == "--pacing") {
+      options.pacing = parsePacingMode(value);
+    } else if (name == "--views") {
+      options.views = parseViews(value);
+    } else if (name == "--fps") {
+      options.targetFps = parseInt(name, value, 1, 1000);
+    } else {
+      THROW_EXCEPTION(std::invalid_argument, "Unknown argument: " + std::string(argument));
+    }
+  }
+  if (!options.capturePath.empty() && options.frameCount == 0) {
+    THROW_EXCEPTION(std::invalid_argument, "--capture needs --frames to know which frame is the last one");
+  }
+#ifdef HW1_BENCHMARK
+  if (options.idle) {
+    THROW_EXCEPTION(std::invalid_argument, "--idle cannot be benchmarked, a still scene draws no frames");
+  }
+#endif
+  if (options.idle && options.frameCount > 0) {
+    THROW_EXCEPTION(std::invalid_argument, "--idle only counts drawn frames, a still scene would never reach --frames");
+  }
+  if (!options.recordPath.empty() && !options.replayPath.empty()) {
+    THROW_EXCEPTION(std::invalid_argument, "--record and --replay cannot be used together");
+  }
+  if (options.stereo && options.renderPath == RenderPath::Immediate) {
+    THROW_EXCEPTION(std::invalid_argument, "--stereo picks the eye in a shader, use --renderer=retained or instanced");
+  }
+  // Replays need the steps to follow the frames, the simulation thread follows the wall clock
+  if (!options.replayPath.empty()) options.simulationThread = false;
+  return options;
+}
+
+const char* toString(RenderPath path) {
+  switch (path) {
+    case RenderPath::Immediate:
+      return "immediate";
+    case RenderPath::Retained:
+      return "retained";
+    case RenderPath::Instanced:
+      return "instanced";
+  }
+  return "unknown";
+}
+
+const char* toString(PacingMode mode) {
+  switch (mode) {
+    case PacingMode::VSync:
+      return "vsync";
+    case PacingMode::Adaptive:
+      return "adaptive";
+    case PacingMode::Uncapped:
+      return "uncapped";
+    case PacingMode::Limit:
+      return "limit";
+  }
+  return "unknown";
+}
+
+const char* toString(ViewKind kind) {
+  switch (kind) {
+    case ViewKind::Main:
+      return "main";
+    case ViewKind::Chase:
+      return "chase";
+    case ViewKind::Overhead:
+      return "overhead";
+    case ViewKind::Cockpit:
+      return "cockpit";
+  }
+  return "unknown";
+}
@@ -0,0 +1,112 @@
+#include "profiler.h"
+
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace profiler {
+namespace {
+/**
+ * @brief One slot of a ring, a seqlock so the dump can read it while its thread overwrites it.
+ *
+ * Event number n sets sequence to 2n + 1 before writing the fields and to 2n + 2 after. The fields are relaxed
+ * atomics, which compile to plain moves, so a reader racing the writer gets stale values instead of undefined
+ * behavior and throws them away when sequence changed in between.
+ */
+struct Event {
+  std::atomic<uint64_t> sequence{0};
+  std::atomic<const char*> name{nullptr};
+  std::atomic<uint64_t> start{0};
+  std::atomic<uint64_t> end{0};
+};
+
+// 64K events (2 MiB) per thread, a few seconds of history at the current instrumentation density
+constexpr std::size_t BUFFER_SIZE = 1 << 16;
+
+/// @brief Single producer ring, only the owning thread writes, the dump reads up to the published count
+struct ThreadBuffer {
+  std::array<Event, BUFFER_SIZE> events;
+  std::atomic<uint64_t> count{0};
+  uint32_t threadId = 0;
+};
+
+const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+// Buffers stay registered after their thread exits so its events still reach the trace
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> registry;
+
+ThreadBuffer* registerThread() {
+  auto buffer = std::make_unique<ThreadBuffer>();
+  std::lock_guard<std::mutex> lock(registryMutex);
+  buffer->threadId = static_cast<uint32_t>(registry.size()) + 1;
+  registry.push_back(std::move(buffer));
+  return registry.back().get();
+}
+
+/// @brief Escape the characters JSON does not allow in strings
+void writeString(std::ostream& out, const char* text) {
+  out << '"';
+  for (; *text != '\0'; ++text) {
+    if (*text == '"' || *text == '\\') out << '\\';
+    out << *text;
+  }
+  out << '"';
+}
+}  // namespace
+
+uint64_t now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void record(const char* name, uint64_t start, uint64_t end) {
+  // Registration locks once per thread, recording itself never locks
+  thread_local ThreadBuffer* buffer = registerThread();
+  uint64_t count = buffer->count.load(std::memory_order_relaxed);
+  Event& event = buffer->events[count % BUFFER_SIZE];
+  event.sequence.store(2 * count + 1, std::memory_order_relaxed);
+  // Orders the odd sequence before the fields, a reader that sees a new field also sees the odd sequence
+  std::atomic_thread_fence(std::memory_order_release);
+  event.name.store(name, std::memory_order_relaxed);
+  event.start.store(start, std::memory_order_relaxed);
+  event.end.store(end, std::memory_order_relaxed);
+  event.sequence.store(2 * count + 2, std::memory_order_release);
+  buffer->count.store(count + 1, std::memory_order_release);
+}
+
+bool writeChromeTrace(const std::string& path) {
+  std::ofstream file(path);
+  if (!file) return false;
+  // Chrome trace times are in microseconds, keep nanosecond resolution
+  file << std::fixed << std::setprecision(3);
+  file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+  bool first = true;
+  std::lock_guard<std::mutex> lock(registryMutex);
+  for (const std::unique_ptr<ThreadBuffer>& buffer : registry) {
+    uint64_t count = buffer->count.load(std::memory_order_acquire);
+    uint64_t begin = count > BUFFER_SIZE ? count - BUFFER_SIZE : 0;
+    for (uint64_t i = begin; i < count; ++i) {
+      const Event& event = buffer->events[i % BUFFER_SIZE];
+      // Copy the slot, skip it if the thread has moved on and is overwriting it
+      uint64_t sequence = event.sequence.load(std::memory_order_acquire);
+      if (sequence != 2 * i + 2) continue;
+      const char* name = event.name.load(std::memory_order_relaxed);
+      uint64_t start = event.start.load(std::memory_order_relaxed);
+      uint64_t end = event.end.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (event.sequence.load(std::memory_order_relaxed) != sequence) continue;
+      if (!first) file << ",\n";
+      first = false;
+      file << "{\"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->threadId << ", \"name\": ";
+      writeString(file, name);
+      file << ", \"ts\": " << start / 1000.0 << ", \"dur\": " << (end - start) / 1000.0 << "}";
+    }
+  }
+  file << "\n]}\n";
+  return static_cast<bool>(file);
+}
+}  // namespace profiler
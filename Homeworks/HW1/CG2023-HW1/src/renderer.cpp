@@ -0,0 +1,420 @@
+#include "renderer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "draw_stats.h"
+#include "gl_state_cache.h"
+
+namespace {
+// Binding point of the "Scene" uniform block
+constexpr GLuint SCENE_UNIFORM_BINDING = 0;
+// World position of the light, same as light() in main.cpp
+constexpr glm::dvec3 LIGHT_POSITION(50.0, 75.0, 80.0);
+
+// GLSL 3.30 so the 3.3 fallback context and macOS 4.1 core contexts can run it too
+constexpr const char* SCENE_VERTEX_SHADER = R"(#version 330 core
+layout(std140) uniform Scene {
+  mat4 view;
+  mat4 projection;
+  vec4 lightPosition;
+  vec4 lightAmbient;
+  vec4 lightDiffuse;
+  vec4 lightSpecular;
+  vec4 sceneAmbient;
+  vec4 materialSpecular;
+};
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+layout(location = 2) in vec3 instanceOffset;
+layout(location = 3) in vec4 instanceColor;
+
+uniform mat4 modelView;
+uniform mat4 partModel;
+uniform vec3 partColor;
+// Stereo draws every instance once per eye, eye views are the camera view moved by the eye offset
+uniform int eyeCount;
+uniform vec3 eyeOffsets[2];
+
+out vec3 viewPosition;
+out vec3 viewNormal;
+out vec3 color;
+flat out vec3 viewLightPosition;
+
+void main() {
+  int eye = gl_InstanceID % eyeCount;
+  // Retained composes everything into modelView on the CPU and leaves the others at identity and zero, instanced
+  // gets the view in modelView, the airplane offset from the camera in the instance buffer and the part in partModel
+  vec4 offsetPosition = partModel * vec4(position, 1.0);
+  offsetPosition.xyz += instanceOffset;
+  vec4 eyePosition = modelView * offsetPosition;
+  eyePosition.xyz += eyeOffsets[eye];
+  viewPosition = eyePosition.xyz;
+  // Parts are only rotated and translated, the scaled board has its normal on the unscaled axis,
+  // so no inverse transpose is needed
+  viewNormal = mat3(modelView) * mat3(partModel) * normal;
+  viewLightPosition = (view * lightPosition).xyz + eyeOffsets[eye];
+  color = partColor * instanceColor.rgb;
+  gl_Position = projection * eyePosition;
+  if (eyeCount == 2) {
+    // Squeeze each eye into its half of the viewport, the clip distance cuts off what spills into the other half
+    float side = eye == 0 ? -1.0 : 1.0;
+    gl_Position.x = 0.5 * (gl_Position.x + side * gl_Position.w);
+    gl_ClipDistance[0] = side * gl_Position.x;
+  } else {
+    gl_ClipDistance[0] = 1.0;
+  }
+}
+)";
+
+constexpr const char* SCENE_FRAGMENT_SHADER = R"(#version 330 core
+layout(std140) uniform Scene {
+  mat4 view;
+  mat4 projection;
+  vec4 lightPosition;
+  vec4 lightAmbient;
+  vec4 lightDiffuse;
+  vec4 lightSpecular;
+  vec4 sceneAmbient;
+  vec4 materialSpecular;
+};
+
+in vec3 viewPosition;
+in vec3 viewNormal;
+in vec3 color;
+flat in vec3 viewLightPosition;
+
+out vec4 fragColor;
+
+void main() {
+  vec3 normal = normalize(viewNormal);
+  vec3 lightDirection = normalize(viewLightPosition - viewPosition);
+  vec3 halfway = normalize(lightDirection - normalize(viewPosition));
+  float diffuse = max(dot(normal, lightDirection), 0.0);
+  float specular = diffuse > 0.0 ? pow(max(dot(normal, halfway), 0.0), materialSpecular.w) : 0.0;
+  vec3 result = color * (sceneAmbient.rgb + lightAmbient.rgb + lightDiffuse.rgb * diffuse) +
+                lightSpecular.rgb * materialSpecular.rgb * specular;
+  fragColor = vec4(min(result, vec3(1.0)), 1.0);
+}
+)";
+
+/// @return Light and material of the scene, view and projection at identity
+SceneUniforms defaultUniforms() {
+  SceneUniforms uniforms;
+  uniforms.view = glm::mat4(1.0f);
+  uniforms.projection = glm::mat4(1.0f);
+  uniforms.lightPosition = glm::vec4(glm::vec3(LIGHT_POSITION), 1.0f);
+  uniforms.lightAmbient = glm::vec4(0.4f, 0.4f, 0.4f, 1.0f);
+  uniforms.lightDiffuse = glm::vec4(0.6f, 0.6f, 0.6f, 1.0f);
+  uniforms.lightSpecular = glm::vec4(0.6f, 0.6f, 0.6f, 1.0f);
+  uniforms.sceneAmbient = glm::vec4(0.2f, 0.2f, 0.2f, 1.0f);
+  // The fixed function default material has no specular, keep it so the scene looks the same
+  uniforms.materialSpecular = glm::vec4(0.0f, 0.0f, 0.0f, 32.0f);
+  return uniforms;
+}
+
+/// @return Parts of the airplane at every level of detail, meshes equal at every level are shared by the cache
+std::array<std::vector<AirplanePart>, LOD_LEVEL_COUNT> makeLevelParts(MeshCache& cache) {
+  std::array<std::vector<AirplanePart>, LOD_LEVEL_COUNT> levelParts;
+  for (int level = 0; level < LOD_LEVEL_COUNT; ++level) {
+    levelParts[level] = makeAirplaneParts(cache, LOD_SEGMENTS[level]);
+  }
+  return levelParts;
+}
+
+/// @brief Point the instance attributes of the bound vertex array at offset bytes into the bound array buffer
+void pointInstanceAttributes(std::size_t offset) {
+  glVertexAttribPointer(INSTANCE_OFFSET_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                        reinterpret_cast<const void*>(offset + offsetof(InstanceData, offset)));
+  glVertexAttribPointer(INSTANCE_COLOR_ATTRIBUTE, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(InstanceData),
+                        reinterpret_cast<const void*>(offset + offsetof(InstanceData, color)));
+}
+}  // namespace
+
+SceneProgram::SceneProgram()
+    : program(SCENE_VERTEX_SHADER, SCENE_FRAGMENT_SHADER),
+      modelViewLocation(program.getUniformLocation("modelView")),
+      partModelLocation(program.getUniformLocation("partModel")),
+      partColorLocation(program.getUniformLocation("partColor")),
+      eyeCountLocation(program.getUniformLocation("eyeCount")),
+      eyeOffsetsLocation(program.getUniformLocation("eyeOffsets")) {
+  glUniformBlockBinding(program.getProgram(), glGetUniformBlockIndex(program.getProgram(), "Scene"),
+                        SCENE_UNIFORM_BINDING);
+  glGenBuffers(1, &uniformBuffer);
+  reserveViews(1);
+  setEyes(1, 0.0f);
+}
+
+SceneProgram::~SceneProgram() {
+  glDeleteBuffers(1, &uniformBuffer);
+  GLStateCache::invalidate();
+}
+
+void SceneProgram::reserveViews(std::size_t count) {
+  if (count <= uploadedCameraVersions.size()) return;
+  GLint alignment = 0;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  alignment = std::max(alignment, 1);
+  viewStride = (sizeof(SceneUniforms) + alignment - 1) / alignment * alignment;
+  // Light and material are the same for every view, the camera parts are uploaded by use()
+  std::vector<unsigned char> data(count * viewStride);
+  SceneUniforms uniforms = defaultUniforms();
+  for (std::size_t i = 0; i < count; ++i) std::memcpy(data.data() + i * viewStride, &uniforms, sizeof(uniforms));
+  GLStateCache::bindBuffer(GL_UNIFORM_BUFFER, uniformBuffer);
+  glBufferData(GL_UNIFORM_BUFFER, data.size(), data.data(), GL_DYNAMIC_DRAW);
+  uploadedCameraVersions.assign(count, 0);
+}
+
+void SceneProgram::use(const Camera& camera, std::size_t view) {
+  program.use();
+  GLintptr offset = static_cast<GLintptr>(view) * viewStride;
+  GLStateCache::bindBufferRange(GL_UNIFORM_BUFFER, SCENE_UNIFORM_BINDING, uniformBuffer, offset,
+                                sizeof(SceneUniforms));
+  if (camera.getVersion() == uploadedCameraVersions[view]) return;
+  uploadedCameraVersions[view] = camera.getVersion();
+  GLStateCache::bindBuffer(GL_UNIFORM_BUFFER, uniformBuffer);
+  // view and projection are the first two members, light and material stay as uploaded
+  glBufferSubData(GL_UNIFORM_BUFFER, offset + offsetof(SceneUniforms, view), sizeof(glm::mat4),
+                  camera.getViewMatrix());
+  glBufferSubData(GL_UNIFORM_BUFFER, offset + offsetof(SceneUniforms, projection), sizeof(glm::mat4),
+                  camera.getProjectionMatrix());
+  glm::vec4 lightPosition(camera.toCameraRelative(LIGHT_POSITION), 1.0f);
+  glBufferSubData(GL_UNIFORM_BUFFER, offset + offsetof(SceneUniforms, lightPosition), sizeof(glm::vec4),
+                  glm::value_ptr(lightPosition));
+}
+
+void SceneProgram::setEyes(int count, float ipd) {
+  program.use();
+  // Moving the eye left moves the scene right in its view space
+  glm::vec3 offsets[2] = {glm::vec3(ipd / 2.0f, 0.0f, 0.0f), glm::vec3(-ipd / 2.0f, 0.0f, 0.0f)};
+  if (count == 1) offsets[0] = glm::vec3(0.0f);
+  glUniform1i(eyeCountLocation, count);
+  glUniform3fv(eyeOffsetsLocation, 2, glm::value_ptr(offsets[0]));
+}
+
+void SceneProgram::setModelView(const float* modelView) const {
+  glUniformMatrix4fv(modelViewLocation, 1, GL_FALSE, modelView);
+}
+
+void SceneProgram::setPart(const glm::mat4& model, const glm::vec3& color) const {
+  glUniformMatrix4fv(partModelLocation, 1, GL_FALSE, glm::value_ptr(model));
+  setPartColor(color);
+}
+
+void SceneProgram::setPartColor(const glm::vec3& color) const {
+  glUniform3fv(partColorLocation, 1, glm::value_ptr(color));
+}
+
+void SceneProgram::setInstance(const glm::vec3& offset, const glm::vec4& color) const {
+  glVertexAttrib3fv(INSTANCE_OFFSET_ATTRIBUTE, glm::value_ptr(offset));
+  setInstanceColor(color);
+}
+
+void SceneProgram::setInstanceColor(const glm::vec4& color) const {
+  glVertexAttrib4fv(INSTANCE_COLOR_ATTRIBUTE, glm::value_ptr(color));
+}
+
+Renderer::Renderer(MeshCache& cache)
+    : board(cache.board(5.0f)),
+      parts(makeAirplaneParts(cache)),
+      levelParts(makeLevelParts(cache)),
+      partTransforms(parts.size(), glm::mat4(1.0f)) {}
+
+void Renderer::setStereo(float ipd) {
+  eyeCount = 2;
+  program.setEyes(eyeCount, ipd);
+  // The vertex shader clips each eye to its half of the viewport
+  GLStateCache::enable(GL_CLIP_DISTANCE0);
+}
+
+void Renderer::beginFrame(const FlightState& _flight, const std::vector<RenderView>& _views) {
+  flight = _flight;
+  views = _views;
+  program.reserveViews(views.size());
+  // Wing animation and heading, camera independent, the flight position is added to every airplane position
+  glm::mat4 rotation = flight.getRotation();
+  for (std::size_t i = 0; i < parts.size(); ++i) {
+    partTransforms[i] = rotation * partTransform(parts[i], flight.wingAngle);
+  }
+}
+
+void Renderer::renderBoard(const Camera& camera) {
+  PROFILE_SCOPE("Renderer::renderBoard");
+  // Same place and scale as the immediate path in main.cpp
+  glm::vec3 origin = camera.toCameraRelative(glm::dvec3(0.0));
+  stack.push();
+  stack.translate(origin.x, origin.y, origin.z);
+  stack.scale(3, 1, 3);
+  program.setModelView(stack.data());
+  program.setInstance(glm::vec3(0.0f), glm::vec4(1.0f));
+  program.setPart(glm::mat4(1.0f), glm::vec3(1.0f));
+  board->mesh.draw(eyeCount);
+  stack.pop();
+}
+
+RetainedRenderer::RetainedRenderer(MeshCache& cache, const std::vector<AirplaneInstance>& _fleet)
+    : Renderer(cache), fleet(_fleet) {}
+
+void RetainedRenderer::render(std::size_t view) {
+  PROFILE_SCOPE("RetainedRenderer::render");
+  const Camera& camera = *views[view].camera;
+  program.use(camera, view);
+  stack.load(glm::make_mat4(camera.getViewMatrix()));
+  // Leaves the instance offset at zero and the part model at identity, only modelView changes per draw
+  renderBoard(camera);
+  if (gpuTimer) gpuTimer->endPass(GpuPass::Board);
+  for (uint32_t index : views[view].culler->getVisible()) {
+    const AirplaneInstance& instance = fleet[index];
+    const std::vector<AirplanePart>& airplaneParts = levelParts[views[view].lod->getLevel(index)];
+    program.setInstanceColor(glm::vec4(instance.color) / 255.0f);
+    // Subtract in double precision, the difference is small next to the camera
+    glm::vec3 offset = camera.toCameraRelative(instance.position + flight.position);
+    stack.push();
+    stack.translate(offset.x, offset.y, offset.z);
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+      stack.push();
+      stack.multiply(partTransforms[i]);
+      program.setModelView(stack.data());
+      program.setPartColor(parts[i].color);
+      airplaneParts[i].mesh->mesh.draw(eyeCount);
+      stack.pop();
+    }
+    stack.pop();
+  }
+  if (gpuTimer) gpuTimer->endPass(GpuPass::Airplanes);
+}
+
+InstancedRenderer::InstancedRenderer(MeshCache& cache, const std::vector<AirplaneInstance>& _fleet)
+    : Renderer(cache), instanceCapacity(_fleet.size()), fleet(_fleet) {
+  visibleInstances.reserve(fleet.size());
+  glGenBuffers(1, &instanceBuffer);
+  GLStateCache::bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+  // Sized for the whole fleet in one view, beginFrame() fills the front with the visible airplanes
+  glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(InstanceData), nullptr, GL_DYNAMIC_DRAW);
+
+  for (int level = 0; level < LOD_LEVEL_COUNT; ++level) {
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+      const AirplanePart& part = levelParts[level][i];
+      if (level > 0 && part.mesh == levelParts[0][i].mesh) {
+        partVertexArrays[level].push_back(partVertexArrays[0][i]);
+        continue;
+      }
+      GLuint vao = 0;
+      glGenVertexArrays(1, &vao);
+      GLStateCache::bindVertexArray(vao);
+      part.mesh->mesh.bindAttributes();
+      GLStateCache::bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+      glEnableVertexAttribArray(INSTANCE_OFFSET_ATTRIBUTE);
+      glVertexAttribDivisor(INSTANCE_OFFSET_ATTRIBUTE, 1);
+      glEnableVertexAttribArray(INSTANCE_COLOR_ATTRIBUTE);
+      glVertexAttribDivisor(INSTANCE_COLOR_ATTRIBUTE, 1);
+      pointInstanceAttributes(0);
+      partVertexArrays[level].push_back(vao);
+      boundFirstInstances[vao] = 0;
+    }
+  }
+}
+
+InstancedRenderer::~InstancedRenderer() {
+  for (const auto& [vao, first] : boundFirstInstances) glDeleteVertexArrays(1, &vao);
+  glDeleteBuffers(1, &instanceBuffer);
+  GLStateCache::invalidate();
+}
+
+void InstancedRenderer::setStereo(float ipd) {
+  Renderer::setStereo(ipd);
+  // Instance i of a draw is airplane i / eyeCount seen by eye i % eyeCount
+  for (const auto& [vao, first] : boundFirstInstances) {
+    GLStateCache::bindVertexArray(vao);
+    glVertexAttribDivisor(INSTANCE_OFFSET_ATTRIBUTE, eyeCount);
+    glVertexAttribDivisor(INSTANCE_COLOR_ATTRIBUTE, eyeCount);
+  }
+}
+
+void InstancedRenderer::beginFrame(const FlightState& _flight, const std::vector<RenderView>& _views) {
+  Renderer::beginFrame(_flight, _views);
+  bool changed = uploadedVersions.size() != views.size();
+  for (std::size_t i = 0; !changed && i < views.size(); ++i) {
+    changed = std::make_pair(views[i].culler->getVersion(), views[i].lod->getVersion()) != uploadedVersions[i];
+  }
+  if (!changed) return;
+  PROFILE_SCOPE("InstancedRenderer::uploadInstances");
+  uploadedVersions.resize(views.size());
+  viewInstances.resize(views.size());
+  visibleInstances.clear();
+  for (std::size_t i = 0; i < views.size(); ++i) {
+    const Camera& camera = *views[i].camera;
+    const FrustumCuller& culler = *views[i].culler;
+    const LodSelector& lod = *views[i].lod;
+    uploadedVersions[i] = {culler.getVersion(), lod.getVersion()};
+    ViewInstances& ranges = viewInstances[i];
+    ranges.all = {visibleInstances.size(), static_cast<GLsizei>(culler.getVisibleCount())};
+    // Counting sort by level, each level becomes a consecutive range
+    std::array<std::size_t, LOD_LEVEL_COUNT> next;
+    std::size_t first = ranges.all.first;
+    for (int level = 0; level < LOD_LEVEL_COUNT; ++level) {
+      ranges.levels[level] = {first, static_cast<GLsizei>(lod.getLevelCounts()[level])};
+      next[level] = first;
+      first += lod.getLevelCounts()[level];
+    }
+    visibleInstances.resize(first);
+    for (uint32_t index : culler.getVisible()) {
+      const AirplaneInstance& instance = fleet[index];
+      // Rebase on the camera of the view in double precision, only the small difference is narrowed
+      visibleInstances[next[lod.getLevel(index)]++] = {camera.toCameraRelative(instance.position + flight.position),
+                                                       instance.color};
+    }
+  }
+  instanceCapacity = std::max(instanceCapacity, visibleInstances.size());
+  GLStateCache::bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+  // Orphan the storage so the upload does not wait for draws of earlier frames
+  glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(InstanceData), nullptr, GL_DYNAMIC_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, visibleInstances.size() * sizeof(InstanceData), visibleInstances.data());
+}
+
+void InstancedRenderer::bindInstances(GLuint vertexArray, std::size_t first) {
+  GLStateCache::bindVertexArray(vertexArray);
+  std::size_t& boundFirst = boundFirstInstances[vertexArray];
+  if (first == boundFirst) return;
+  boundFirst = first;
+  GLStateCache::bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+  pointInstanceAttributes(first * sizeof(InstanceData));
+}
+
+void InstancedRenderer::drawInstances(GLuint vertexArray, const AirplanePart& part, const InstanceRange& range) {
+  // Nothing visible, nothing to draw
+  if (range.count == 0) return;
+  // Views and levels share the instance buffer, each one starts at its own range
+  bindInstances(vertexArray, range.first);
+  glDrawElementsInstanced(GL_TRIANGLES, part.mesh->mesh.getIndexCount(), GL_UNSIGNED_INT, nullptr,
+                          range.count * eyeCount);
+  DrawStats::record(part.mesh->mesh.getIndexCount(), range.count * eyeCount);
+}
+
+void InstancedRenderer::render(std::size_t view) {
+  PROFILE_SCOPE("InstancedRenderer::render");
+  const Camera& camera = *views[view].camera;
+  const ViewInstances& ranges = viewInstances[view];
+  program.use(camera, view);
+  stack.load(glm::make_mat4(camera.getViewMatrix()));
+  // The board vertex array has no instance buffer, it reads the constant instance attributes
+  renderBoard(camera);
+  if (gpuTimer) gpuTimer->endPass(GpuPass::Board);
+  program.setModelView(stack.data());
+  for (std::size_t i = 0; i < parts.size(); ++i) {
+    program.setPart(partTransforms[i], parts[i].color);
+    if (partVertexArrays[0][i] == partVertexArrays[1][i]) {
+      // Same mesh at every level, one draw for the whole view
+      drawInstances(partVertexArrays[0][i], parts[i], ranges.all);
+      continue;
+    }
+    for (int level = 0; level < LOD_LEVEL_COUNT; ++level) {
+      drawInstances(partVertexArrays[level][i], levelParts[level][i], ranges.levels[level]);
+    }
+  }
+  if (gpuTimer) gpuTimer->endPass(GpuPass::Airplanes);
+}
@@ -0,0 +1,60 @@
+#include "shader.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace {
+GLuint compileShader(GLenum type, const char* source) {
+  GLuint shader = glCreateShader(type);
+  glShaderSource(shader, 1, &source, nullptr);
+  glCompileShader(shader);
+  GLint success = GL_FALSE;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+  if (success == GL_FALSE) {
+    GLint length = 0;
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+    std::string log(length, '\0');
+    glGetShaderInfoLog(shader, length, nullptr, log.data());
+    glDeleteShader(shader);
+    THROW_EXCEPTION(std::runtime_error, std::string(type == GL_VERTEX_SHADER ? "Vertex" : "Fragment") +
+                                            " shader compile error: " + log);
+  }
+  return shader;
+}
+}  // namespace
+
+ShaderProgram::ShaderProgram(const char* vertexSource, const char* fragmentSource) {
+  GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+  GLuint fragmentShader = 0;
+  try {
+    fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+  } catch (...) {
+    glDeleteShader(vertexShader);
+    throw;
+  }
+  program = glCreateProgram();
+  glAttachShader(program, vertexShader);
+  glAttachShader(program, fragmentShader);
+  glLinkProgram(program);
+  // Shaders are no longer needed once the program is linked
+  glDetachShader(program, vertexShader);
+  glDetachShader(program, fragmentShader);
+  glDeleteShader(vertexShader);
+  glDeleteShader(fragmentShader);
+
+  GLint success = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
+  if (success == GL_FALSE) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+    std::string log(length, '\0');
+    glGetProgramInfoLog(program, length, nullptr, log.data());
+    glDeleteProgram(program);
+    THROW_EXCEPTION(std::runtime_error, "Program link error: " + log);
+  }
+}
+
+ShaderProgram::~ShaderProgram() {
+  glDeleteProgram(program);
+  GLStateCache::invalidate();
+}
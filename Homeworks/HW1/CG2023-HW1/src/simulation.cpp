@@ -0,0 +1,134 @@
+#include "simulation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+SimulationInput sampleInput(const KeyState& keys, const Camera& camera) {
+  SimulationInput input;
+  if (keys[GLFW_KEY_W]) {
+    input.cameraDirection = camera.getFront();
+  } else if (keys[GLFW_KEY_S]) {
+    input.cameraDirection = -camera.getFront();
+  } else if (keys[GLFW_KEY_A]) {
+    input.cameraDirection = -camera.getRight();
+  } else if (keys[GLFW_KEY_D]) {
+    input.cameraDirection = camera.getRight();
+  }
+  input.fly = keys[GLFW_KEY_SPACE];
+  input.turnLeft = keys[GLFW_KEY_LEFT];
+  input.turnRight = keys[GLFW_KEY_RIGHT];
+  return input;
+}
+
+bool SimulationInput::isActive() const {
+  return cameraDirection != glm::vec3(0.0f) || fly || turnLeft || turnRight;
+}
+
+SimulationState interpolate(const SimulationState& a, const SimulationState& b, float alpha) {
+  SimulationState state;
+  state.cameraPosition = glm::mix(a.cameraPosition, b.cameraPosition, static_cast<double>(alpha));
+  state.flight = interpolate(a.flight, b.flight, alpha);
+  return state;
+}
+
+Simulation::Simulation(const SimulationState& initial, double time)
+    : previous(initial), current(initial), lastTime(time) {}
+
+int Simulation::advance(const SimulationInput& input, double time) {
+  PROFILE_SCOPE("Simulation::advance");
+  accumulator += time - lastTime;
+  lastTime = time;
+  int steps = 0;
+  while (accumulator >= STEP && steps < MAX_STEPS_PER_FRAME) {
+    previous = current;
+    step(current, input);
+    accumulator -= STEP;
+    ++steps;
+  }
+  // Too far behind, give up on the rest instead of catching up over the next frames
+  if (steps == MAX_STEPS_PER_FRAME) accumulator = std::min(accumulator, STEP);
+  stepCount += steps;
+  return steps;
+}
+
+SimulationState Simulation::getRenderState() const {
+  return interpolate(previous, current, static_cast<float>(std::min(accumulator / STEP, 1.0)));
+}
+
+bool Simulation::isMoving() const {
+  return previous.cameraPosition != current.cameraPosition || previous.flight != current.flight;
+}
+
+void Simulation::step(SimulationState& state, const SimulationInput& input) {
+  state.cameraPosition += glm::dvec3(input.cameraDirection) * (CAMERA_MOVE_SPEED * STEP);
+
+  FlightState& flight = state.flight;
+  if (input.turnLeft) flight.heading += ROTATE_SPEED;
+  if (input.turnRight) flight.heading -= ROTATE_SPEED;
+  if (input.fly) {
+    // The nose points to -z at heading 0
+    float heading = glm::radians(flight.heading);
+    glm::vec3 forward(-std::sin(heading), 0.0f, -std::cos(heading));
+    flight.position += glm::dvec3((forward + glm::vec3(0.0f, 1.0f, 0.0f)) * (FLYING_SPEED));
+    // Flap up and down, turn around at the limits
+    flight.wingAngle += flight.flapDirection * (WING_FLAP_SPEED);
+    if (std::abs(flight.wingAngle) >= MAX_WING_ANGLE) {
+      flight.wingAngle = std::clamp(flight.wingAngle, -MAX_WING_ANGLE, MAX_WING_ANGLE);
+      flight.flapDirection = -flight.flapDirection;
+    }
+  } else {
+    // Glide back down to the board and let the wings settle
+    flight.position.y = std::max(0.0, flight.position.y - (FLYING_SPEED));
+    float settle = std::min(std::abs(flight.wingAngle), (WING_FLAP_SPEED));
+    flight.wingAngle -= std::copysign(settle, flight.wingAngle);
+  }
+}
+
+SimulationThread::SimulationThread(const SimulationState& initial, double time)
+    : snapshots(Snapshot{initial, initial, time}), thread(&SimulationThread::run, this, initial, time) {}
+
+SimulationThread::~SimulationThread() {
+  running.store(false, std::memory_order_relaxed);
+  thread.join();
+}
+
+void SimulationThread::setInput(const SimulationInput& _input) {
+  input.write() = _input;
+  input.publish();
+}
+
+SimulationState SimulationThread::getRenderState(double time) {
+  const Snapshot& snapshot = snapshots.read();
+  // The newest step is shown once its time is reached, earlier frames stay between the two before it
+  float alpha = static_cast<float>(std::clamp((time - snapshot.time) / Simulation::STEP, 0.0, 1.0));
+  return interpolate(snapshot.previous, snapshot.current, alpha);
+}
+
+bool SimulationThread::isMoving() {
+  const Snapshot& snapshot = snapshots.read();
+  return snapshot.previous.cameraPosition != snapshot.current.cameraPosition ||
+         snapshot.previous.flight != snapshot.current.flight;
+}
+
+void SimulationThread::run(SimulationState state, double time) {
+  while (running.load(std::memory_order_relaxed)) {
+    // Same schedule as Simulation::advance, a step runs once its time has passed
+    time += Simulation::STEP;
+    double now = glfwGetTime();
+    if (now - time > Simulation::MAX_STEPS_PER_FRAME * Simulation::STEP) {
+      // Too far behind, give up on the missed steps
+      time = now;
+    } else if (time > now) {
+      std::this_thread::sleep_for(std::chrono::duration<double>(time - now));
+    }
+    PROFILE_SCOPE("SimulationThread::step");
+    Snapshot& snapshot = snapshots.write();
+    snapshot.previous = state;
+    Simulation::step(state, input.read());
+    snapshot.current = state;
+    snapshot.time = time;
+    snapshots.publish();
+    stepCount.fetch_add(1, std::memory_order_relaxed);
+  }
+}
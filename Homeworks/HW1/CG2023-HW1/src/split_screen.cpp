@@ -0,0 +1,84 @@
+#include "split_screen.h"
+
+#include <cmath>
+
+namespace {
+// Chase camera, behind and above the lead airplane
+constexpr double CHASE_DISTANCE = 14.0;
+constexpr double CHASE_HEIGHT = 5.0;
+// Overhead camera, straight above the lead airplane
+constexpr double OVERHEAD_HEIGHT = 40.0;
+// Cockpit camera, just in front of the nose at z = -2 so the body does not fill the view
+constexpr double COCKPIT_FORWARD = 2.5;
+constexpr double COCKPIT_HEIGHT = 1.0;
+}  // namespace
+
+SplitScreen::SplitScreen(const std::vector<ViewKind>& kinds, Camera& _main, const std::vector<AirplaneInstance>& fleet,
+                         const BoundingSphere& bounds, bool _stereo)
+    : main(_main), stereo(_stereo), leadOffset(fleet.front().position) {
+  views.reserve(kinds.size());
+  for (ViewKind kind : kinds) {
+    View view{kind, &main, nullptr, FrustumCuller(fleet, bounds), LodSelector(fleet.size(), bounds)};
+    if (kind != ViewKind::Main) {
+      view.follower = std::make_unique<Camera>(main.getPosition());
+      view.follower->initialize(1.0f, main.isReverseZ());
+      view.camera = view.follower.get();
+    }
+    views.push_back(std::move(view));
+  }
+}
+
+glm::ivec2 SplitScreen::gridSize() const {
+  int columns = views.size() > 1 ? 2 : 1;
+  int rows = static_cast<int>((views.size() + columns - 1) / columns);
+  return glm::ivec2(columns, rows);
+}
+
+void SplitScreen::resize(int width, int height) {
+  glm::ivec2 grid = gridSize();
+  glm::ivec2 cell(width / grid.x, height / grid.y);
+  for (std::size_t i = 0; i < views.size(); ++i) {
+    int column = static_cast<int>(i) % grid.x;
+    int row = static_cast<int>(i) / grid.x;
+    views[i].viewport = glm::ivec4(column * cell.x, height - (row + 1) * cell.y, cell.x, cell.y);
+  }
+  updateProjections(width, height);
+}
+
+void SplitScreen::updateProjections(int width, int height) {
+  glm::ivec2 grid = gridSize();
+  if (width <= 0 || height <= 0) return;
+  float aspectRatio = static_cast<float>(width) / grid.x / (static_cast<float>(height) / grid.y);
+  if (stereo) aspectRatio /= 2.0f;
+  // The main camera keeps following the window even when no view shows it
+  main.updateProjectionMatrix(aspectRatio);
+  for (View& view : views) {
+    if (view.follower) view.follower->updateProjectionMatrix(aspectRatio);
+  }
+}
+
+void SplitScreen::follow(const FlightState& flight) {
+  glm::dvec3 lead = flight.position + leadOffset;
+  // The nose points to -z at heading 0, see Simulation::step
+  double heading = glm::radians(static_cast<double>(flight.heading));
+  glm::dvec3 forward(-std::sin(heading), 0.0, -std::cos(heading));
+  for (View& view : views) {
+    switch (view.kind) {
+      case ViewKind::Main:
+        break;
+      case ViewKind::Chase:
+        view.follower->setPosition(lead - forward * CHASE_DISTANCE + glm::dvec3(0.0, CHASE_HEIGHT, 0.0));
+        view.follower->lookAt(lead);
+        break;
+      case ViewKind::Overhead:
+        view.follower->setPosition(lead + glm::dvec3(0.0, OVERHEAD_HEIGHT, 0.0));
+        // Looking straight down, -z is up on the screen
+        view.follower->lookAt(lead, glm::vec3(0.0f, 0.0f, -1.0f));
+        break;
+      case ViewKind::Cockpit:
+        view.follower->setPosition(lead + forward * COCKPIT_FORWARD + glm::dvec3(0.0, COCKPIT_HEIGHT, 0.0));
+        view.follower->lookAt(view.follower->getPosition() + forward);
+        break;
+    }
+  }
+}